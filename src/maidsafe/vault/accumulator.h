@@ -20,8 +20,13 @@
 #define MAIDSAFE_VAULT_ACCUMULATOR_H_
 
 #include <algorithm>
+#include <chrono>
+#include <cstdint>
 #include <deque>
+#include <functional>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "maidsafe/common/data_types/data_name_variant.h"
@@ -30,6 +35,7 @@
 #include "maidsafe/nfs/types.h"
 #include "maidsafe/nfs/vault/messages.h"
 #include "maidsafe/vault/handled_request.pb.h"
+#include "maidsafe/vault/parameters.h"
 #include "maidsafe/vault/types.h"
 
 namespace maidsafe {
@@ -47,6 +53,52 @@ class MessageIdRequestVisitor : public boost::static_visitor<nfs::MessageId> {
   }
 };
 
+// Estimates a message's size without serialising it: the message itself plus any chunk or other
+// bulk data its contents carry in a 'data' string, directly or within an optional 'content'.  The
+// rest of the contents are small next to that.
+class SizeEstimateVisitor : public boost::static_visitor<size_t> {
+ public:
+  template <typename T>
+  size_t operator()(const T& message) const {
+    return sizeof(message) + (message.contents ? DataSize(*message.contents, 0) : 0);
+  }
+
+ private:
+  template <typename Contents>
+  static auto DataSize(const Contents& contents, int) -> decltype(contents.data.size()) {
+    return contents.data.size();
+  }
+  template <typename Contents>
+  static auto DataSize(const Contents& contents, long)  // NOLINT
+      -> decltype(contents.content->data.size()) {
+    return contents.content ? contents.content->data.size() : 0;
+  }
+  template <typename Contents>
+  static size_t DataSize(const Contents& /*contents*/, ...) {
+    return 0;
+  }
+};
+
+// A group's requests for one message share a key: the message id and type, and the group's id.
+struct AccumulatorKey {
+  AccumulatorKey(uint64_t message_key_in, const routing::GroupId& group_id_in)
+      : message_key(message_key_in), group_id(group_id_in) {}
+  uint64_t message_key;  // see Accumulator::MessageKey
+  routing::GroupId group_id;
+};
+
+inline bool operator==(const AccumulatorKey& lhs, const AccumulatorKey& rhs) {
+  return lhs.message_key == rhs.message_key && lhs.group_id == rhs.group_id;
+}
+
+// Hashes just the message key; requests for the same message from different groups are rare, and
+// the group id would otherwise have to be copied out of its NodeId.
+struct AccumulatorKeyHash {
+  size_t operator()(const AccumulatorKey& key) const {
+    return std::hash<uint64_t>()(key.message_key);
+  }
+};
+
 /*
 class ContentEraseVisitor : public boost::static_visitor<> {
  public:
@@ -72,7 +124,55 @@ class Accumulator {
     kFailure,
     kHandled
   };
-  typedef std::function<AddResult(const std::vector<T>&)> AddCheckerFunctor;
+  // A group's requests for one message.  Each distinct request is held once, and each sender just
+  // records a digest of its id and which of the distinct requests it sent, so a large message
+  // costs a few bytes per sender rather than a copy each.
+  class Requests {
+   public:
+    Requests()
+        : contents_(),
+          vote_counts_(),
+          votes_(),
+          latest_index_(0),
+          winner_index_(0),
+          deadline_(),
+          byte_size_(0) {}
+    // The number of senders' requests, and the i'th of them in the order they arrived.
+    size_t size() const { return votes_.size(); }
+    bool empty() const { return votes_.empty(); }
+    const T& at(size_t index) const { return contents_.at(votes_.at(index).content_index); }
+    // The distinct requests, and the number of senders of each.
+    size_t distinct_size() const { return contents_.size(); }
+    const T& distinct_at(size_t index) const { return contents_.at(index); }
+    size_t vote_count(size_t index) const { return vote_counts_.at(index); }
+    // The distinct request which the latest new vote was for, and its number of senders.
+    const T& latest() const { return contents_.at(latest_index_); }
+    size_t latest_vote_count() const { return vote_counts_.at(latest_index_); }
+    // The distinct request with the most senders (the earliest such on a tie), and its number of
+    // senders.
+    const T& winner() const { return contents_.at(winner_index_); }
+    size_t winner_vote_count() const { return vote_counts_.at(winner_index_); }
+
+   private:
+    friend class Accumulator;
+    struct Vote {
+      Vote(uint64_t sender_in, uint32_t content_index_in)
+          : sender(sender_in), content_index(content_index_in) {}
+      uint64_t sender;
+      uint32_t content_index;
+    };
+    // Returns false if the sender has already sent this request.
+    bool AddVote(const T& request, uint64_t sender);
+
+    std::vector<T> contents_;
+    std::vector<size_t> vote_counts_;
+    std::vector<Vote> votes_;
+    uint32_t latest_index_, winner_index_;
+    std::chrono::steady_clock::time_point deadline_;
+    // Estimated size of the distinct requests, plus the votes
+    size_t byte_size_;
+  };
+  typedef std::function<AddResult(const Requests&)> AddCheckerFunctor;
   class AddRequestChecker {
    public:
     explicit AddRequestChecker(size_t required_requests)
@@ -81,28 +181,27 @@ class Accumulator {
              "Invalid number of requests");
     }
 
-    AddResult operator()(const std::vector<T>& requests);
+    AddResult operator()(const Requests& requests);
 
    private:
     size_t required_requests_;
   };
 
-  struct PendingRequest {
-    PendingRequest(const T& request_in, const routing::GroupSource& source_in)
-        : request(request_in), source(source_in) {}
-    T request;
-    routing::GroupSource source;
-  };
-
-  Accumulator();
+  explicit Accumulator(const detail::AccumulatorOptions& options = detail::AccumulatorOptions());
 
   AddResult AddPendingRequest(const T& request, const routing::GroupSource& source,
                               AddCheckerFunctor checker);
   AddResult AddPendingRequest(const T& request, const routing::SingleSource& source,
                               AddCheckerFunctor checker);
 
-  bool CheckHandled(const T& request);
-  //  void SetHandled(const T& request, const routing::GroupSource& source);
+  // True if the request's message has been handled for the source's group.
+  bool CheckHandled(const T& request, const routing::GroupSource& source);
+  // Drops the request's pending requests and records its message as handled for the source's group,
+  // so that late requests for it from the rest of that group are refused.  The same message from
+  // another group is still accumulated.  Only the latest
+  // kMaxHandledRequestsCount_ messages are remembered, and none if that's 0.
+  void SetHandled(const T& request, const routing::GroupSource& source);
+  void SetHandled(const T& request, const routing::SingleSource& source);
   std::vector<T> Get(const T& request, const routing::GroupSource& source);
 
  private:
@@ -111,19 +210,59 @@ class Accumulator {
   Accumulator(Accumulator&&);
   Accumulator& operator=(Accumulator&&);
 
-  bool RequestExists(const T& request, const routing::GroupSource& source);
+  typedef std::unordered_map<detail::AccumulatorKey, Requests, detail::AccumulatorKeyHash>
+      PendingRequestMap;
+
+  // Packs the request's message id and variant index into one integer.
+  static uint64_t MessageKey(const T& request);
+  static uint64_t SenderDigest(const routing::GroupSource& source);
+  struct PendingOrderEntry {
+    PendingOrderEntry(const detail::AccumulatorKey& key_in,
+                      std::chrono::steady_clock::time_point deadline_in)
+        : key(key_in), deadline(deadline_in) {}
+    bool operator==(const PendingOrderEntry& other) const {
+      return key == other.key && deadline == other.deadline;
+    }
+    detail::AccumulatorKey key;
+    std::chrono::steady_clock::time_point deadline;
+  };
 
-  std::deque<PendingRequest> pending_requests_;
-  std::deque<T> handled_requests_;
-  const size_t kMaxPendingRequestsCount_, kMaxHandledRequestsCount_;
+  // Drops messages whose deadline has passed, then the oldest others while over the count or size
+  // limit.  The message of 'current' is never dropped.
+  void PrunePendingRequests(const PendingOrderEntry& current);
+  // Pops the front of 'pending_order_' and erases its message.  Returns false if the entry was
+  // left behind by a handled message.
+  bool EraseOldestRequests();
+
+  PendingRequestMap pending_requests_;
+  // Each pending message's key and deadline, oldest first.  A message's entry is left behind when
+  // it's handled, and is skipped unless its deadline matches the pending message's.
+  std::deque<PendingOrderEntry> pending_order_;
+  size_t pending_size_;
+  // The keys of handled requests, and the same keys in a ring buffer, oldest first from
+  // 'handled_index_', so the oldest can be forgotten once there are kMaxHandledRequestsCount_.
+  std::unordered_set<detail::AccumulatorKey, detail::AccumulatorKeyHash> handled_requests_;
+  std::vector<detail::AccumulatorKey> handled_order_;
+  size_t handled_index_;
+  const std::chrono::steady_clock::duration kPendingRequestLifetime_;
+  const size_t kMaxPendingRequestsCount_, kMaxPendingRequestsSize_, kMaxHandledRequestsCount_;
 };
 
 template <typename T>
-Accumulator<T>::Accumulator()
+Accumulator<T>::Accumulator(const detail::AccumulatorOptions& options)
     : pending_requests_(),
+      pending_order_(),
+      pending_size_(0),
       handled_requests_(),
-      kMaxPendingRequestsCount_(300),
-      kMaxHandledRequestsCount_(1000) {}
+      handled_order_(),
+      handled_index_(0),
+      kPendingRequestLifetime_(options.pending_request_lifetime),
+      kMaxPendingRequestsCount_(options.max_pending_requests_count),
+      kMaxPendingRequestsSize_(options.max_pending_requests_size),
+      kMaxHandledRequestsCount_(options.max_handled_requests_count) {
+  handled_requests_.reserve(kMaxHandledRequestsCount_);
+  handled_order_.reserve(kMaxHandledRequestsCount_);
+}
 
 template <typename T>
 typename Accumulator<T>::AddResult Accumulator<T>::AddPendingRequest(
@@ -131,21 +270,32 @@ typename Accumulator<T>::AddResult Accumulator<T>::AddPendingRequest(
   LOG(kVerbose) << "Accumulator::AddPendingRequest for GroupSource "
                 << HexSubstr(source.group_id.data.string()) << " sent from "
                 << HexSubstr(source.sender_id->string());
-  if (CheckHandled(request)) {
+  if (CheckHandled(request, source)) {
     LOG(kInfo) << "Accumulator::AddPendingRequest request has been handled";
     return Accumulator<T>::AddResult::kHandled;
   }
 
-  if (!RequestExists(request, source)) {
-    pending_requests_.push_back(PendingRequest(request, source));
+  const detail::AccumulatorKey key(MessageKey(request), source.group_id);
+  auto& pending(pending_requests_[key]);
+  if (pending.empty()) {
+    pending.deadline_ = std::chrono::steady_clock::now() + kPendingRequestLifetime_;
+    pending_order_.push_back(PendingOrderEntry(key, pending.deadline_));
+  }
+  const size_t previous_byte_size(pending.byte_size_);
+  if (pending.AddVote(request, SenderDigest(source))) {
+    pending_size_ += pending.byte_size_ - previous_byte_size;
+    // Other messages' entries may be erased, but not this one's, so 'pending' remains valid.
+    PrunePendingRequests(PendingOrderEntry(key, pending.deadline_));
     LOG(kVerbose) << "Accumulator::AddPendingRequest has " << pending_requests_.size()
-                  << " pending requests, allowing " << kMaxPendingRequestsCount_ << " requests";
-    if (pending_requests_.size() > kMaxPendingRequestsCount_)
-      pending_requests_.pop_front();
+                  << " pending messages of " << pending_size_ << " bytes, allowing "
+                  << kMaxPendingRequestsCount_ << " messages of " << kMaxPendingRequestsSize_
+                  << " bytes";
   } else {
-    LOG(kInfo) << "Accumulator::AddPendingRequest request already existed";
+    LOG(kWarning) << "Accumulator::AddPendingRequest request from sender "
+                  << HexSubstr(source.sender_id->string()) << " with group_id "
+                  << HexSubstr(source.group_id->string()) << " already exists";
   }
-  return checker(Get(request, source));
+  return checker(pending);
 }
 
 template <typename T>
@@ -156,84 +306,119 @@ typename Accumulator<T>::AddResult Accumulator<T>::AddPendingRequest(
 }
 
 template <typename T>
-bool Accumulator<T>::CheckHandled(const T& request) {
-  auto request_message_id(boost::apply_visitor(detail::MessageIdRequestVisitor(), request));
-  nfs::MessageId message_id;
-  for (auto handled_request : handled_requests_) {
-    if (handled_request.which() == request.which()) {
-      message_id = boost::apply_visitor(detail::MessageIdRequestVisitor(), handled_request);
-      if (message_id == request_message_id)
-        return true;
-    }
+bool Accumulator<T>::CheckHandled(const T& request, const routing::GroupSource& source) {
+  return handled_requests_.count(detail::AccumulatorKey(MessageKey(request), source.group_id)) != 0;
+}
+
+template <typename T>
+void Accumulator<T>::SetHandled(const T& request, const routing::GroupSource& source) {
+  const detail::AccumulatorKey key(MessageKey(request), source.group_id);
+  const auto itr(pending_requests_.find(key));
+  if (itr != std::end(pending_requests_)) {
+    pending_size_ -= itr->second.byte_size_;
+    pending_requests_.erase(itr);
+  }
+  if (kMaxHandledRequestsCount_ == 0 || !handled_requests_.insert(key).second)
+    return;
+  if (handled_order_.size() < kMaxHandledRequestsCount_) {
+    handled_order_.push_back(key);
+  } else {
+    handled_requests_.erase(handled_order_[handled_index_]);
+    handled_order_[handled_index_] = key;
+    handled_index_ = (handled_index_ + 1) % kMaxHandledRequestsCount_;
   }
-  return false;
 }
 
-// template<typename T>
-// void Accumulator<T>::SetHandled(const T& request, const routing::GroupSource& source) {
-//    assert(!CheckHandled(request) && "Request has already been set as handled");
-//    nfs::MessageId message_id;
-//    auto request_message_id(boost::apply_visitor(detail::MessageIdRequestVisitor(), request));
-//    boost::apply_visitor(detail::ContentEraseVisitor(), request);
-//    for (auto itr(std::begin(pending_requests_)); itr != std::end(pending_requests_);) {
-//        if (itr->request.which() == request.which()) {
-//            message_id = boost::apply_visitor(detail::MessageIdRequestVisitor(), itr->request);
-//            if ((message_id == request_message_id) && (source.group_id == itr->source.group_id))
-//                pending_requests_.erase(itr);
-//            else
-//                ++itr;
-//        } else {
-//            ++itr;
-//        }
-//    }
-//    boost::apply_visitor(detail::ContentEraseVisitor(), request);
-//    handled_requests_.push_back(request);
-//    if (handled_requests_.size() > kMaxHandledRequestsCount_)
-//        handled_requests_.pop_front();
-// }
+template <typename T>
+void Accumulator<T>::SetHandled(const T& /*request*/, const routing::SingleSource& /*source*/) {}
 
 template <typename T>
 std::vector<T> Accumulator<T>::Get(const T& request, const routing::GroupSource& source) {
   std::vector<T> requests;
-  nfs::MessageId message_id;
-  auto request_message_id(boost::apply_visitor(detail::MessageIdRequestVisitor(), request));
-  for (auto pending_request : pending_requests_) {
-    if (pending_request.request.which() == request.which()) {
-      message_id = boost::apply_visitor(detail::MessageIdRequestVisitor(), pending_request.request);
-      if (((message_id == request_message_id)) &&
-          (source.group_id == pending_request.source.group_id))
-        requests.push_back(pending_request.request);
-    }
-  }
-  LOG(kVerbose) << requests.size() << " requests are found for the request bearing message id "
-                << request_message_id.data;
+  const auto itr(pending_requests_.find(detail::AccumulatorKey(MessageKey(request),
+                                                               source.group_id)));
+  if (itr == std::end(pending_requests_))
+    return requests;
+  LOG(kVerbose) << itr->second.size()
+                << " requests are found for the request bearing message id "
+                << boost::apply_visitor(detail::MessageIdRequestVisitor(), request).data;
+  requests.reserve(itr->second.size());
+  for (size_t i(0); i != itr->second.size(); ++i)
+    requests.push_back(itr->second.at(i));
   return requests;
 }
 
 template <typename T>
-bool Accumulator<T>::RequestExists(const T& request, const routing::GroupSource& source) {
-  auto request_message_id(boost::apply_visitor(detail::MessageIdRequestVisitor(), request));
-  for (auto pending_request : pending_requests_)
-    if (request_message_id ==
-            boost::apply_visitor(detail::MessageIdRequestVisitor(), pending_request.request)
-        && source == pending_request.source && pending_request.request == request) {
-      LOG(kWarning) << "Accumulator<T>::RequestExists,  reguest with message id "
-                    << request_message_id.data << " from sender "
-                    << HexSubstr(source.sender_id->string())
-                    << " with group_id " << HexSubstr(source.group_id->string())
-                    << " already exists in the pending requests list";
-      return true;
-    }
-  LOG(kInfo) << "Accumulator<T>::RequestExists,  reguest with message id "
-             << request_message_id.data << " from sender " << HexSubstr(source.sender_id->string())
-             << " with group_id " << HexSubstr(source.group_id->string())
-             << " doesn't exists in the pending requests list";
-  return false;
+uint64_t Accumulator<T>::MessageKey(const T& request) {
+  const auto message_id(boost::apply_visitor(detail::MessageIdRequestVisitor(), request));
+  return (static_cast<uint64_t>(static_cast<uint32_t>(message_id.data)) << 32) |
+         static_cast<uint32_t>(request.which());
+}
+
+template <typename T>
+uint64_t Accumulator<T>::SenderDigest(const routing::GroupSource& source) {
+  // FNV-1a over the sender's id; the group is already part of the requests' key.
+  uint64_t digest(14695981039346656037ULL);
+  for (char byte : source.sender_id->string()) {
+    digest ^= static_cast<unsigned char>(byte);
+    digest *= 1099511628211ULL;
+  }
+  return digest;
+}
+
+template <typename T>
+void Accumulator<T>::PrunePendingRequests(const PendingOrderEntry& current) {
+  const auto now(std::chrono::steady_clock::now());
+  while (pending_order_.front().deadline <= now && !(pending_order_.front() == current)) {
+    if (EraseOldestRequests())
+      LOG(kInfo) << "Accumulator::PrunePendingRequests dropped an expired message";
+  }
+  while ((pending_requests_.size() > kMaxPendingRequestsCount_ ||
+          pending_size_ > kMaxPendingRequestsSize_) &&
+         !(pending_order_.front() == current)) {
+    if (EraseOldestRequests())
+      LOG(kWarning) << "Accumulator::PrunePendingRequests dropped a message to stay within limits";
+  }
+}
+
+template <typename T>
+bool Accumulator<T>::EraseOldestRequests() {
+  const PendingOrderEntry entry(pending_order_.front());
+  pending_order_.pop_front();
+  const auto itr(pending_requests_.find(entry.key));
+  if (itr == std::end(pending_requests_) || itr->second.deadline_ != entry.deadline)
+    return false;
+  pending_size_ -= itr->second.byte_size_;
+  pending_requests_.erase(itr);
+  return true;
+}
+
+template <typename T>
+bool Accumulator<T>::Requests::AddVote(const T& request, uint64_t sender) {
+  // There's normally just one distinct request, so this is a single comparison.
+  uint32_t content_index(0);
+  while (content_index != contents_.size() && !(contents_[content_index] == request))
+    ++content_index;
+  if (content_index == contents_.size()) {
+    contents_.push_back(request);
+    vote_counts_.push_back(0);
+    byte_size_ += boost::apply_visitor(detail::SizeEstimateVisitor(), request);
+  } else if (std::any_of(std::begin(votes_), std::end(votes_), [&](const Vote& vote) {
+               return vote.sender == sender && vote.content_index == content_index;
+             })) {
+    return false;
+  }
+  votes_.push_back(Vote(sender, content_index));
+  byte_size_ += sizeof(Vote);
+  latest_index_ = content_index;
+  if (++vote_counts_[content_index] > vote_counts_[winner_index_])
+    winner_index_ = content_index;
+  return true;
 }
 
 template <typename T>
 typename Accumulator<T>::AddResult Accumulator<T>::AddRequestChecker::operator()(
-    const std::vector<T>& requests) {
+    const Requests& requests) {
   LOG(kVerbose) << "Accumulator<T>::AddRequestChecker operator(),  required_requests_ : "
                 << required_requests_ << " , checking against " << requests.size()
                 << " requests";
@@ -246,22 +431,11 @@ typename Accumulator<T>::AddResult Accumulator<T>::AddRequestChecker::operator()
   if (requests.size() < required_requests_) {
     LOG(kInfo) << "Accumulator<T>::AddRequestChecke::operator() not enough pending requests";
     return AddResult::kWaiting;
-  } else {
-    auto index(0);
-    while ((requests.size() - index) >= required_requests_) {
-      if (std::count_if(std::begin(requests), std::end(requests), [&](const T& request) {
-            if (requests.at(index) == request) {
-              LOG(kVerbose) << "requests match each other";
-              return true;
-            } else {
-              LOG(kVerbose) << "requests don't match each other";
-              return false;
-            }
-          }) == static_cast<int>(required_requests_))
-        return AddResult::kSuccess;
-      ++index;
-    }
   }
+  // Succeeds only as the latest vote brings its request to the quorum, so that later matching
+  // requests aren't acted on again.
+  if (requests.latest_vote_count() == required_requests_)
+    return AddResult::kSuccess;
   LOG(kInfo) << "Accumulator<T>::AddRequestChecke::operator() the reqeust is still waiting";
   return AddResult::kWaiting;
 }
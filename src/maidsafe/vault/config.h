@@ -20,7 +20,10 @@
 #define MAIDSAFE_VAULT_CONFIG_H_
 
 #include <functional>
+#include <memory>
+#include <string>
 
+#include "maidsafe/common/error.h"
 #include "maidsafe/common/data_types/data_name_variant.h"
 
 namespace maidsafe {
@@ -41,6 +44,17 @@ enum class GroupDbMetaDataStatus {
   kGroupNonEmpty
 };
 
+// Folds a merge operand, written by Db::Merge or GroupDb::Merge, into 'value' (null if there's no
+// value yet).  Returning kDelete leaves no value.  Value types which support merges specialise
+// this with kEnabled set; no operands are ever stored for any other type.
+template <typename Value>
+struct MergeOperator {
+  static const bool kEnabled = false;
+  static DbAction Apply(const std::string& /*operand*/, std::unique_ptr<Value>& /*value*/) {
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_parameter));
+  }
+};
+
 }  // namespace detail
 
 }  // namespace vault
@@ -49,24 +49,40 @@ inline bool ForThisPersona(const Message& message) {
 }  // unnamed namespace
 
 DataManagerService::DataManagerService(const passport::Pmid& pmid, routing::Routing& routing,
-                                       nfs_client::DataGetter& data_getter)
+                                       nfs_client::DataGetter& data_getter,
+                                       const boost::filesystem::path& vault_root_dir)
     : routing_(routing),
       asio_service_(2),
       data_getter_(data_getter),
       accumulator_mutex_(),
       matrix_change_mutex_(),
-      accumulator_(),
+      accumulator_(detail::Parameters::data_manager_accumulator_options),
       matrix_change_(),
       dispatcher_(routing_, pmid),
       get_timer_(asio_service_),
       get_cached_response_timer_(asio_service_),
-      db_(),
+      db_(detail::PersonaDbPath(vault_root_dir, "data_manager"),
+          detail::Parameters::data_manager_db_options,
+          detail::Parameters::data_manager_db_cache_capacity),
       sync_puts_(NodeId(pmid.name()->string())),
       sync_deletes_(NodeId(pmid.name()->string())),
       sync_add_pmids_(NodeId(pmid.name()->string())),
       sync_remove_pmids_(NodeId(pmid.name()->string())),
       sync_node_downs_(NodeId(pmid.name()->string())),
-      sync_node_ups_(NodeId(pmid.name()->string())) {
+      sync_node_ups_(NodeId(pmid.name()->string())),
+      sync_retransmitters_() {
+  sync_retransmitters_.push_back(
+      detail::MakeSyncRetransmitter(asio_service_, dispatcher_, sync_puts_));
+  sync_retransmitters_.push_back(
+      detail::MakeSyncRetransmitter(asio_service_, dispatcher_, sync_deletes_));
+  sync_retransmitters_.push_back(
+      detail::MakeSyncRetransmitter(asio_service_, dispatcher_, sync_add_pmids_));
+  sync_retransmitters_.push_back(
+      detail::MakeSyncRetransmitter(asio_service_, dispatcher_, sync_remove_pmids_));
+  sync_retransmitters_.push_back(
+      detail::MakeSyncRetransmitter(asio_service_, dispatcher_, sync_node_downs_));
+  sync_retransmitters_.push_back(
+      detail::MakeSyncRetransmitter(asio_service_, dispatcher_, sync_node_ups_));
 }
 
 // ==================== Put implementation =========================================================
@@ -299,12 +315,25 @@ void DataManagerService::HandleMessage(
     const typename SynchroniseFromDataManagerToDataManager::Sender& sender,
     const typename SynchroniseFromDataManagerToDataManager::Receiver& /*receiver*/) {
   LOG(kVerbose) << "DataManagerService::HandleMessage SynchroniseFromDataManagerToDataManager";
-  protobuf::Sync proto_sync;
-  if (!proto_sync.ParseFromString(message.contents->data)) {
+  protobuf::SyncBatch proto_sync_batch;
+  if (!proto_sync_batch.ParseFromString(message.contents->data)) {
     LOG(kError) << "SynchroniseFromDataManagerToDataManager can't parse content";
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
   }
 
+  for (const auto& proto_sync : proto_sync_batch.syncs()) {
+    try {
+      HandleSync(proto_sync, sender);
+    }
+    catch (const maidsafe_error& error) {
+      LOG(kError) << "SynchroniseFromDataManagerToDataManager failed to handle action type "
+                  << proto_sync.action_type() << ": " << boost::diagnostic_information(error);
+    }
+  }
+}
+
+void DataManagerService::HandleSync(const protobuf::Sync& proto_sync,
+                                    const routing::GroupSource& sender) {
   switch (static_cast<nfs::MessageAction>(proto_sync.action_type())) {
     case ActionDataManagerPut::kActionId: {
       LOG(kVerbose) << "SynchroniseFromDataManagerToDataManager ActionDataManagerPut";
@@ -312,8 +341,8 @@ void DataManagerService::HandleMessage(
                                                    sender.sender_id, routing_.kNodeId());
       auto resolved_action(sync_puts_.AddUnresolvedAction(unresolved_action));
       if (resolved_action) {
-        LOG(kInfo) << "SynchroniseFromDataManagerToDataManager commit put to db";
-        db_.Commit(resolved_action->key, resolved_action->action);
+        LOG(kInfo) << "SynchroniseFromDataManagerToDataManager merge put into db";
+        db_.Merge(resolved_action->key, detail::MergeOperator<DataManagerValue>::MakeOperand(1));
       }
       break;
     }
@@ -433,6 +462,9 @@ void DataManagerService::HandleChurnEvent(std::shared_ptr<routing::MatrixChange>
   LOG(kVerbose) << "HandleChurnEvent matrix_change containing following info : ";
 //   matrix_change->Print();
   matrix_change_ = *matrix_change;
+  auto cache_stats(db_.GetCacheStats());
+  LOG(kInfo) << "HandleChurnEvent db cache hits: " << cache_stats.hits
+             << ", misses: " << cache_stats.misses;
   LOG(kVerbose) << "HandleChurnEvent matrix_change_ containing following info after : ";
 //   matrix_change_.Print();
 }
@@ -48,6 +48,7 @@
 #include "maidsafe/vault/operation_visitors.h"
 #include "maidsafe/vault/parameters.h"
 #include "maidsafe/vault/sync.h"
+#include "maidsafe/vault/sync.pb.h"
 #include "maidsafe/vault/types.h"
 #include "maidsafe/vault/data_manager/action_put.h"
 #include "maidsafe/vault/data_manager/data_manager.h"
@@ -72,8 +73,10 @@ class DataManagerService {
   typedef DataManagerServiceMessages VaultMessages;
   typedef void HandleMessageReturnType;
 
+  // If 'vault_root_dir' is empty, the db is not persisted.
   DataManagerService(const passport::Pmid& pmid, routing::Routing& routing,
-                     nfs_client::DataGetter& data_getter);
+                     nfs_client::DataGetter& data_getter,
+                     const boost::filesystem::path& vault_root_dir = boost::filesystem::path());
 
   template <typename MessageType>
   void HandleMessage(const MessageType& message, const typename MessageType::Sender& sender,
@@ -87,6 +90,9 @@ class DataManagerService {
   DataManagerService(DataManagerService&&);
   DataManagerService& operator=(DataManagerService&&);
 
+  // Applies one action from a received batch of syncs.
+  void HandleSync(const protobuf::Sync& proto_sync, const routing::GroupSource& sender);
+
   // =========================== Put section =======================================================
   template <typename Data>
   void HandlePut(const Data& data, const MaidName& maid_name, const PmidName& pmid_name,
@@ -255,6 +261,7 @@ class DataManagerService {
   Sync<DataManager::UnresolvedRemovePmid> sync_remove_pmids_;
   Sync<DataManager::UnresolvedNodeDown> sync_node_downs_;
   Sync<DataManager::UnresolvedNodeUp> sync_node_ups_;
+  std::vector<std::unique_ptr<detail::SyncRetransmitter>> sync_retransmitters_;
 
  protected:
   std::mutex lock_guard;
@@ -399,19 +406,14 @@ void DataManagerService::HandlePut(const Data& data, const MaidName& maid_name,
 
 template <typename Data>
 bool DataManagerService::EntryExist(const typename Data::Name& name) {
-  try {
-    db_.Get(DataManager::Key(name.value, Data::Tag::kValue));
-    LOG(kInfo) << "Entry does not exist";
+  DataManager::Key key(name.value, Data::Tag::kValue);
+  // Most puts are of new data, which the existence filter rules out without a db read.
+  if (db_.MayExist(key) && db_.Exists(key)) {
+    LOG(kInfo) << "Entry exists";
     return true;
   }
-  catch (const maidsafe_error& /*error*/) {
-    LOG(kInfo) << "Entry does not exist";
-    return false;
-  }
-  catch (...) {
-    assert(0 && "DataManagerService::EntryExist");
-    return false;
-  }
+  LOG(kInfo) << "Entry does not exist";
+  return false;
 }
 
 template <typename Data>
@@ -463,15 +465,9 @@ void DataManagerService::HandlePutFailure(const typename Data::Name& data_name,
   // Get all pmid nodes for this data.
   if (SendPutRetryRequired(data_name)) {
     std::set<PmidName> pmids_to_avoid;
-    try {
-      auto value(db_.Get(key));
-      pmids_to_avoid = std::move(value.AllPmids());
-    } catch (const common_error& error) {
-      if (error.code() != make_error_code(CommonErrors::no_such_element)) {
-        LOG(kError) << "HandlePutFailure db error";
-        throw error;  // For db errors
-      }
-    }
+    auto value(db_.TryGet(key));
+    if (value)
+      pmids_to_avoid = std::move(value->AllPmids());
 
     pmids_to_avoid.insert(attempted_pmid_node);
     auto pmid_name(PmidName(Identity(routing_.RandomConnectedNode().string())));
@@ -496,13 +492,9 @@ void DataManagerService::HandlePutFailure(const typename Data::Name& data_name,
 
 template <typename DataName>
 bool DataManagerService::SendPutRetryRequired(const DataName& data_name) {
-  try {
-    // mutex is required
-    auto value(db_.Get(DataManager::Key(data_name.value, DataName::data_type::Tag::kValue)));
-    return value.AllPmids().size() < routing::Parameters::group_size;
-  }
-  catch (const maidsafe_error& /*error*/) {}
-  return false;
+  // mutex is required
+  auto value(db_.TryGet(DataManager::Key(data_name.value, DataName::data_type::Tag::kValue)));
+  return value && value->AllPmids().size() < routing::Parameters::group_size;
 }
 
 // ==================== Get / IntegrityCheck implementation ========================================
@@ -513,19 +505,15 @@ void DataManagerService::HandleGet(const typename Data::Name& data_name,
   LOG(kVerbose) << "DataManagerService::HandleGet " << HexSubstr(data_name.value);
   // Get all pmid nodes that are online.
   std::set<PmidName> online_pmids;
-  try {
-    auto value(db_.Get(DataManager::Key(data_name.value, Data::Tag::kValue)));
-    online_pmids = std::move(value.online_pmids());
-  } catch (const maidsafe_error& error) {
-    LOG(kWarning) << "Getting " << HexSubstr(data_name.value)
-                  << " causes a maidsafe_error " << boost::diagnostic_information(error);
-    if (error.code() != make_error_code(VaultErrors::no_such_account)) {
-      LOG(kError) << "db error";
-      throw error;  // For db errors
+  {
+    auto value(db_.TryGet(DataManager::Key(data_name.value, Data::Tag::kValue)));
+    if (!value) {
+      // TODO(Fraser#5#): 2013-10-03 - Request for non-existent data should possibly generate an
+      // alert
+      LOG(kWarning) << "Entry for " << HexSubstr(data_name.value) << " doesn't exist.";
+      return;
     }
-    // TODO(Fraser#5#): 2013-10-03 - Request for non-existent data should possibly generate an alert
-    LOG(kWarning) << "Entry for " << HexSubstr(data_name.value) << " doesn't exist.";
-    return;
+    online_pmids = std::move(value->online_pmids());
   }
 
   int expected_response_count(static_cast<int>(online_pmids.size()));
@@ -800,12 +788,7 @@ void DataManagerService::MarkNodeUp(const PmidName& pmid_node, const DataName& n
 
 template <typename UnresolvedAction>
 void DataManagerService::DoSync(const UnresolvedAction& unresolved_action) {
-  detail::IncrementAttemptsAndSendSync(dispatcher_, sync_puts_, unresolved_action);
-  detail::IncrementAttemptsAndSendSync(dispatcher_, sync_deletes_, unresolved_action);
-  detail::IncrementAttemptsAndSendSync(dispatcher_, sync_add_pmids_, unresolved_action);
-  detail::IncrementAttemptsAndSendSync(dispatcher_, sync_remove_pmids_, unresolved_action);
-  detail::IncrementAttemptsAndSendSync(dispatcher_, sync_node_downs_, unresolved_action);
-  detail::IncrementAttemptsAndSendSync(dispatcher_, sync_node_ups_, unresolved_action);
+  detail::SendSyncAction(dispatcher_, unresolved_action);
 }
 
 }  // namespace vault
@@ -159,6 +159,32 @@ void DataManagerValue::PrintRecords() {
   }
 }
 
+namespace detail {
+
+std::string MergeOperator<DataManagerValue>::MakeOperand(int64_t subscribers) {
+  protobuf::DataManagerValueDelta delta_proto;
+  delta_proto.set_subscribers(subscribers);
+  return delta_proto.SerializeAsString();
+}
+
+DbAction MergeOperator<DataManagerValue>::Apply(const std::string& operand,
+                                                std::unique_ptr<DataManagerValue>& value) {
+  protobuf::DataManagerValueDelta delta_proto;
+  if (!delta_proto.ParseFromString(operand)) {
+    LOG(kError) << "Failed to parse data manager value merge operand.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+  }
+  if (!value) {
+    LOG(kWarning) << "DataManagerValue merge operand for a missing value; ignored";
+    return DbAction::kDelete;
+  }
+  value->subscribers_ += delta_proto.subscribers();
+  GLOG() << "DataManager merged subscribers to " << value->subscribers_;
+  return value->subscribers_ < 1 ? DbAction::kDelete : DbAction::kPut;
+}
+
+}  // namespace detail
+
 }  // namespace vault
 
 }  // namespace maidsafe
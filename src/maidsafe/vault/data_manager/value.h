@@ -20,12 +20,14 @@
 #define MAIDSAFE_VAULT_DATA_MANAGER_VALUE_H_
 
 #include <cstdint>
+#include <memory>
 #include <set>
 #include <string>
 
 #include "maidsafe/common/types.h"
 #include "maidsafe/common/data_types/data_name_variant.h"
 
+#include "maidsafe/vault/config.h"
 #include "maidsafe/vault/data_manager/data_manager.pb.h"
 #include "maidsafe/vault/types.h"
 
@@ -33,6 +35,22 @@ namespace maidsafe {
 
 namespace vault {
 
+class DataManagerValue;
+
+namespace detail {
+
+// Allows subscribers to be added by Db::Merge without reading the value.
+template <>
+struct MergeOperator<DataManagerValue> {
+  static const bool kEnabled = true;
+  static std::string MakeOperand(int64_t subscribers);
+  // An operand for a missing value is dropped, as the value must first be created with its pmids.
+  // The value is deleted if its subscribers drop below one.
+  static DbAction Apply(const std::string& operand, std::unique_ptr<DataManagerValue>& value);
+};
+
+}  // namespace detail
+
 // not thread safe
 class DataManagerValue {
  public:
@@ -57,6 +75,7 @@ class DataManagerValue {
   std::set<PmidName> online_pmids() const { return online_pmids_; }
 
   friend bool operator==(const DataManagerValue& lhs, const DataManagerValue& rhs);
+  friend struct detail::MergeOperator<DataManagerValue>;
 #ifdef MAIDSAFE_APPLE  // BEFORE_RELEASE This copy constructor definition is to allow building
                        // on mac with clang 3.3, should be removed if clang is updated on mac.
   DataManagerValue(const DataManagerValue& other)
@@ -19,6 +19,8 @@
 #ifndef MAIDSAFE_VAULT_DB_H_
 #define MAIDSAFE_VAULT_DB_H_
 
+#include <functional>
+#include <list>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -32,6 +34,9 @@
 
 #include "maidsafe/routing/matrix_change.h"
 #include "maidsafe/vault/config.h"
+#include "maidsafe/vault/parameters.h"
+#include "maidsafe/vault/storage_engine.h"
+#include "maidsafe/vault/utils.h"
 
 
 namespace maidsafe {
@@ -42,43 +47,110 @@ template <typename Key, typename Value>
 class Db {
  public:
   typedef std::pair<Key, Value> KvPair;
-  typedef std::map<NodeId, std::vector<KvPair>> TransferInfo;
+  // Transfers carry values as stored, so they're never parsed on either the sending or receiving
+  // side.
+  typedef std::pair<Key, std::string> SerialisedKvPair;
+  typedef std::function<void(const NodeId& new_holder, std::vector<SerialisedKvPair> kv_pairs)>
+      TransferFunctor;
+  struct CacheStats {
+    CacheStats() : hits(0), misses(0) {}
+    uint64_t hits, misses;
+  };
 
-  Db();
-  ~Db();
+  // If 'db_path' is empty, the db is created at a unique temporary path and destroyed along with
+  // this object.  Otherwise the db at 'db_path' is opened (or created if missing) and left on disk.
+  // 'db_options' chooses the storage engine; an in-memory engine never touches 'db_path'.
+  // If 'cache_capacity' is non-zero, up to that many decoded values are kept in an LRU cache which
+  // serves TryGet.
+  explicit Db(const boost::filesystem::path& db_path = boost::filesystem::path(),
+              const detail::DbOptions& db_options = detail::DbOptions(),
+              size_t cache_capacity = 0);
 
+  // Reads don't lock the db mutex (storage engine reads are thread-safe), so never block behind a
+  // Commit or a GetTransferInfo scan.
+  // Throws VaultErrors::no_such_account if the key isn't in the db.
   Value Get(const Key& key);
+  // Returns null if the key isn't in the db.  Throws only on db errors.  The value may be shared
+  // with the cache, so is immutable.
+  std::shared_ptr<const Value> TryGet(const Key& key);
+  // Checks for the key without reading or parsing its value.  Throws only on db errors.
+  bool Exists(const Key& key);
+  // Returns false only if the key is definitely not in the db, from an in-memory filter and
+  // without touching leveldb.  A true result must be confirmed by Exists or TryGet.
+  bool MayExist(const Key& key) const;
   // if functor returns DbAction::kDelete, the value is deleted from db
   std::unique_ptr<Value> Commit(
       const Key& key, std::function<detail::DbAction(std::unique_ptr<Value>& value)> functor);
-  TransferInfo GetTransferInfo(std::shared_ptr<routing::MatrixChange> matrix_change);
-  void HandleTransfer(const std::vector<KvPair>& contents);
+  // Appends 'operand' to the key's value without reading or parsing the value.  Operands are
+  // folded in by detail::MergeOperator<Value>, in the order merged, whenever the value is read,
+  // committed or transferred.  Once Parameters::max_pending_merge_operands are pending, the next
+  // merge folds them and its own operand into the stored value, so reads never write.
+  void Merge(const Key& key, const std::string& operand);
+  // Hands entries which have moved out of range to 'functor' in bounded batches, one batch per new
+  // holder at a time, and prunes entries still in range.
+  void GetTransferInfo(std::shared_ptr<routing::MatrixChange> matrix_change,
+                       TransferFunctor functor);
+  void HandleTransfer(const std::vector<SerialisedKvPair>& contents);
+  CacheStats GetCacheStats() const;
 
  private:
+  typedef std::list<std::pair<Key, std::shared_ptr<const Value>>> CacheList;
+
   Db(const Db&);
   Db& operator=(const Db&);
   Db(Db&&);
   Db& operator=(Db&&);
-  void Delete(const Key& key);
-  void Put(const KvPair& key_value_pair);
+  // The keys of any merge operands folded into the returned value are appended to 'operand_keys'
+  // if it's non-null.
+  std::unique_ptr<Value> Read(const Key& key, std::vector<std::string>* operand_keys = nullptr);
+  // Writes the value back with its pending merge operands and 'operand' folded in.  Must be called
+  // with 'mutex_' held.
+  void FoldMergeOperands(const Key& key, const std::string& operand);
+  bool Contains(leveldb::Iterator& db_iter, const leveldb::Slice& db_key) const;
+  std::shared_ptr<const Value> FindInCache(const Key& key, uint64_t& generation);
+  void AddToCache(const Key& key, std::shared_ptr<const Value> value, uint64_t generation);
+  // Replaces the cached value for 'key' (erasing it if 'value' is null).  Must be called for every
+  // write to the db.
+  void UpdateCache(const Key& key, std::shared_ptr<const Value> value);
+  void InsertIntoCache(const Key& key, std::shared_ptr<const Value> value);
+  void LoadExistenceFilter();
 
+  // Size of every db key other than a merge operand's
+  static const size_t kKeySize_ = Key::kFixedWidthSize;
+  typedef detail::FixedWidthKey<kKeySize_> DbKey;
+  static DbKey MakeDbKey(const Key& key);
+  const bool kPersistent_;
   const boost::filesystem::path kDbPath_;
+  const bool kVerifyChecksums_;
   mutable std::mutex mutex_;
-  std::unique_ptr<leveldb::DB> leveldb_;
+  std::unique_ptr<detail::StorageEngine> storage_engine_;
+  // Every key written is added before the write is made, so a key in the db is always in here.
+  detail::ExistenceFilter existence_filter_;
+  // 'cache_generation_' is bumped by every write, so a TryGet which read from leveldb before a
+  // write doesn't then cache a stale value.
+  const size_t kCacheCapacity_;
+  mutable std::mutex cache_mutex_;
+  CacheList cache_list_;
+  std::map<Key, typename CacheList::iterator> cache_index_;
+  uint64_t cache_generation_;
+  CacheStats cache_stats_;
 };
 
 template <typename Key, typename Value>
-Db<Key, Value>::Db()
-    : kDbPath_(boost::filesystem::unique_path()), mutex_(), leveldb_() {
-  leveldb::DB* db;
-  leveldb::Options options;
-  options.create_if_missing = true;
-  options.error_if_exists = true;
-  leveldb::Status status(leveldb::DB::Open(options, kDbPath_.string(), &db));
-  if (!status.ok())
-    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
-  leveldb_ = std::move(std::unique_ptr<leveldb::DB>(db));
-  assert(leveldb_);
+Db<Key, Value>::Db(const boost::filesystem::path& db_path, const detail::DbOptions& db_options,
+                   size_t cache_capacity)
+    : kPersistent_(!db_path.empty()),
+      kDbPath_(kPersistent_ ? db_path : boost::filesystem::unique_path()),
+      kVerifyChecksums_(db_options.verify_checksums),
+      mutex_(),
+      storage_engine_(detail::InitialiseStorageEngine(kDbPath_, kPersistent_, db_options)),
+      existence_filter_(detail::Parameters::db_existence_filter_bits),
+      kCacheCapacity_(cache_capacity),
+      cache_mutex_(),
+      cache_list_(),
+      cache_index_(),
+      cache_generation_(0),
+      cache_stats_() {
 #if defined(__GNUC__) && (!defined(MAIDSAFE_APPLE) && !(defined(_MSC_VER) && _MSC_VER == 1700))
   // Remove this assert if value needs to be copy constructible.
   // this is just a check to avoid copy constructor unless we require it
@@ -87,16 +159,19 @@ Db<Key, Value>::Db()
   static_assert(std::is_move_constructible<Value>::value,
                 "value should be move constructible !");
 #endif
+  if (kPersistent_)
+    LoadExistenceFilter();
 }
 
 template <typename Key, typename Value>
-Db<Key, Value>::~Db() {
-  try {
-    leveldb::DestroyDB(kDbPath_.string(), leveldb::Options());
-    boost::filesystem::remove_all(kDbPath_);
-  } catch (const std::exception& e) {
-    LOG (kError) << "Failed to remove db : " << boost::diagnostic_information(e);
-  }
+void Db<Key, Value>::LoadExistenceFilter() {
+  leveldb::ReadOptions read_options;
+  read_options.fill_cache = false;
+  std::unique_ptr<leveldb::Iterator> db_iter(storage_engine_->NewIterator(read_options));
+  for (db_iter->SeekToFirst(); db_iter->Valid(); db_iter->Next())
+    existence_filter_.Add(leveldb::Slice(db_iter->key().data(), kKeySize_));
+  if (!db_iter->status().ok())
+    BOOST_THROW_EXCEPTION(MakeError(VaultErrors::failed_to_handle_request));
 }
 
 template <typename Key, typename Value>
@@ -104,121 +179,316 @@ std::unique_ptr<Value> Db<Key, Value>::Commit(const Key& key,
     std::function<detail::DbAction(std::unique_ptr<Value>& value)> functor) {
   assert(functor);
   std::lock_guard<std::mutex> lock(mutex_);
-  std::unique_ptr<Value> value;
-  try {
-    value.reset(new Value(Get(key)));
-  } catch (const maidsafe_error& error) {
-    if (error.code() != make_error_code(VaultErrors::no_such_account)) {
-      LOG(kError) << "Db<Key, Value>::Commit unknown db error "
-                  << boost::diagnostic_information(error);
-      throw error;  // For db errors
-    }
-  }
+  std::vector<std::string> operand_keys;
+  std::unique_ptr<Value> value(Read(key, &operand_keys));
+  const DbKey db_key(MakeDbKey(key));
+  // Any merge operands have been folded into 'value', so are removed in the same batch as the
+  // value is written.
+  detail::DbBatchWriter batch_writer(*storage_engine_);
+  for (const auto& operand_key : operand_keys)
+    batch_writer.Delete(operand_key);
   if (detail::DbAction::kPut == functor(value)) {
     assert(value);
     if (!value)
       BOOST_THROW_EXCEPTION(MakeError(CommonErrors::null_pointer));
 
     LOG(kInfo) << "Db<Key, Value>::Commit putting entry";
-    Put(KvPair(key, Value(std::move(*value))));
+    existence_filter_.Add(db_key);
+    batch_writer.Put(db_key, value->Serialise());
+    batch_writer.Flush();
+    UpdateCache(key, std::shared_ptr<const Value>(std::move(value)));
   } else {
     LOG(kInfo) << "Db<Key, Value>::Commit deleting entry";
     assert(value);
-    Delete(key);
+    batch_writer.Delete(db_key);
+    batch_writer.Flush();
+    UpdateCache(key, nullptr);
     return value;
   }
   return nullptr;
 }
 
-// option 1 : Fire functor here with check_holder_result.new_holder & the corresponding value
-// option 2 : create a map<NodeId, std::vector<std::pair<Key, value>>> and return after pruning
 template <typename Key, typename Value>
-typename Db<Key, Value>::TransferInfo Db<Key, Value>::GetTransferInfo(
-    std::shared_ptr<routing::MatrixChange> matrix_change) {
+void Db<Key, Value>::Merge(const Key& key, const std::string& operand) {
+  static_assert(detail::MergeOperator<Value>::kEnabled, "Value doesn't support merges");
+  const DbKey db_key(MakeDbKey(key));
   std::lock_guard<std::mutex> lock(mutex_);
-  std::vector<std::string> prune_vector;
-  TransferInfo transfer_info;
-  {
-    std::unique_ptr<leveldb::Iterator> db_iter(leveldb_->NewIterator(leveldb::ReadOptions()));
-    for (db_iter->SeekToFirst(); db_iter->Valid(); db_iter->Next()) {
-      Key key(typename Key::FixedWidthString(db_iter->key().ToString()));
-      auto check_holder_result = matrix_change->CheckHolders(NodeId(key.name.string()));
-      if (check_holder_result.proximity_status != routing::GroupRangeStatus::kInRange) {
-        if (check_holder_result.new_holders.size() != 0) {
-          assert(check_holder_result.new_holders.size() == 1);
-          auto found_itr = transfer_info.find(check_holder_result.new_holders.at(0));
-          if (found_itr != transfer_info.end()) {
-            found_itr->second.push_back(std::make_pair(key, Value(db_iter->value().ToString())));
-          } else {  // create
-            std::vector<KvPair> kv_pair;
-            kv_pair.push_back(std::make_pair(key, Value(db_iter->value().ToString())));
-            transfer_info.insert(std::make_pair(check_holder_result.new_holders.at(0),
-                                                std::move(kv_pair)));
+  existence_filter_.Add(db_key);
+  std::unique_ptr<leveldb::Iterator> db_iter(storage_engine_->NewIterator(leveldb::ReadOptions()));
+  const uint64_t sequence(detail::NextMergeSequence(*db_iter, db_key));
+  db_iter.reset();
+  if (sequence >= Parameters::max_pending_merge_operands)
+    return FoldMergeOperands(key, operand);
+  leveldb::Status status(
+      storage_engine_->Put(detail::MakeMergeOperandKey(db_key, sequence), operand));
+  if (!status.ok()) {
+    LOG(kError) << "Db<Key, Value>::Merge incorrect leveldb::Status";
+    BOOST_THROW_EXCEPTION(MakeError(VaultErrors::failed_to_handle_request));
+  }
+  UpdateCache(key, nullptr);
+}
+
+template <typename Key, typename Value>
+void Db<Key, Value>::FoldMergeOperands(const Key& key, const std::string& operand) {
+  LOG(kVerbose) << "Db<Key, Value>::FoldMergeOperands";
+  std::vector<std::string> operand_keys;
+  std::unique_ptr<Value> value(Read(key, &operand_keys));
+  if (detail::MergeOperator<Value>::Apply(operand, value) == detail::DbAction::kDelete)
+    value.reset();
+  const DbKey db_key(MakeDbKey(key));
+  detail::DbBatchWriter batch_writer(*storage_engine_);
+  for (const auto& operand_key : operand_keys)
+    batch_writer.Delete(operand_key);
+  if (value)
+    batch_writer.Put(db_key, value->Serialise());
+  else
+    batch_writer.Delete(db_key);
+  batch_writer.Flush();
+  UpdateCache(key, value ? std::shared_ptr<const Value>(std::move(value)) : nullptr);
+}
+
+// Scans the db in chunks of at most Parameters::max_transfer_batch_count entries, holding the
+// mutex only while scanning a chunk.  Entries for new holders are buffered until the total
+// buffered reaches that same limit, then handed to 'functor' (without the mutex held) in one batch
+// per new holder, so memory use is bounded regardless of the size of the db.
+template <typename Key, typename Value>
+void Db<Key, Value>::GetTransferInfo(std::shared_ptr<routing::MatrixChange> matrix_change,
+                                     TransferFunctor functor) {
+  assert(functor);
+  std::map<NodeId, std::vector<SerialisedKvPair>> batches;
+  auto flush_batches([&] {
+    for (auto& batch : batches)
+      functor(batch.first, std::move(batch.second));
+    batches.clear();
+  });
+
+  // Each chunk is read under 'mutex_' by its own iterator, so it sees every write made before it,
+  // and resumes from the first key the previous chunk didn't consume.
+  std::string resume_key;
+  bool done(false);
+  while (!done) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      std::unique_ptr<leveldb::Iterator> db_iter(
+          storage_engine_->NewIterator(leveldb::ReadOptions()));
+      if (resume_key.empty())
+        db_iter->SeekToFirst();
+      else
+        db_iter->Seek(resume_key);
+      detail::DbBatchWriter batch_writer(*storage_engine_);
+      // The cache is updated for pruned keys only once their deletions are written, so a TryGet
+      // in between can't cache a value again.
+      std::vector<Key> pruned_keys;
+      // Each step consumes a value along with any merge operands stored after it.
+      for (size_t scanned(0); db_iter->Valid() && scanned != Parameters::max_transfer_batch_count;
+           ++scanned) {
+        const DbKey db_key(db_iter->key());
+        Key key(Key::FromFixedWidth(db_key.data()));
+        auto check_holder_result = matrix_change->CheckHolders(NodeId(key.name.string()));
+        if (check_holder_result.proximity_status != routing::GroupRangeStatus::kInRange) {
+          std::string value_string;
+          if (detail::ReadMergedValue<Value>(*db_iter, db_key, value_string, nullptr) &&
+              check_holder_result.new_holders.size() != 0) {
+            assert(check_holder_result.new_holders.size() == 1);
+            batches[check_holder_result.new_holders.at(0)].push_back(
+                std::make_pair(key, value_string));
           }
+        } else {
+          for (; db_iter->Valid() && db_iter->key().starts_with(db_key); db_iter->Next())
+            batch_writer.Delete(db_iter->key());
+          pruned_keys.push_back(key);
         }
-      } else {
-        prune_vector.push_back(db_iter->key().data());
       }
+      if (!db_iter->status().ok())
+        BOOST_THROW_EXCEPTION(MakeError(VaultErrors::failed_to_handle_request));
+      done = !db_iter->Valid();
+      if (!done)
+        resume_key = db_iter->key().ToString();
+      db_iter.reset();
+      batch_writer.Flush();
+      for (const auto& pruned_key : pruned_keys)
+        UpdateCache(pruned_key, nullptr);
     }
+    flush_batches();
   }
-
-  for (const auto& key_string : prune_vector)
-    leveldb_->Delete(leveldb::WriteOptions(), key_string);  // Ignore Delete failure here ?
-  return transfer_info;
 }
 
-// Ignores values which are already in db
+// Ignores values which are already in db.  Merge operands left pending on an absent value (which
+// were dropped whenever it was read) are removed as the transferred value is written, so they
+// aren't applied to it.
 template <typename Key, typename Value>
-void Db<Key, Value>::HandleTransfer(const std::vector<std::pair<Key, Value>>& contents) {
+void Db<Key, Value>::HandleTransfer(const std::vector<SerialisedKvPair>& contents) {
   std::lock_guard<std::mutex> lock(mutex_);
+  detail::DbBatchWriter batch_writer(*storage_engine_);
+  std::unique_ptr<leveldb::Iterator> db_iter(storage_engine_->NewIterator(leveldb::ReadOptions()));
+  std::vector<const Key*> written_keys;
   for (const auto& kv_pair : contents) {
-    try {
-      Get(kv_pair.first);
-    } catch (const common_error& error) {
-      if (error.code() != make_error_code(CommonErrors::no_such_element))
-        throw error;  // For db errors
-      else
-        Put(kv_pair);
+    const DbKey db_key(MakeDbKey(kv_pair.first));
+    if (!existence_filter_.MayContain(db_key)) {
+      existence_filter_.Add(db_key);
+    } else if (Contains(*db_iter, db_key)) {
+      continue;
+    } else {
+      // 'db_iter' is left at the first entry after 'db_key', where any of its operands would be.
+      for (; db_iter->Valid() && db_iter->key().starts_with(db_key) &&
+             db_iter->key().size() == db_key.size() + detail::MergeSequenceWidth::value;
+           db_iter->Next()) {
+        batch_writer.Delete(db_iter->key());
+      }
     }
+    batch_writer.Put(db_key, kv_pair.second);
+    written_keys.push_back(&kv_pair.first);
   }
+  if (!db_iter->status().ok())
+    BOOST_THROW_EXCEPTION(MakeError(VaultErrors::failed_to_handle_request));
+  db_iter.reset();
+  batch_writer.Flush();
+  for (const auto& written_key : written_keys)
+    UpdateCache(*written_key, nullptr);
+}
+
+// Checks for the key by seeking, so the stored value is neither copied nor parsed.
+template <typename Key, typename Value>
+bool Db<Key, Value>::Contains(leveldb::Iterator& db_iter, const leveldb::Slice& db_key) const {
+  db_iter.Seek(db_key);
+  return db_iter.Valid() && db_iter.key() == db_key;
+}
+
+template <typename Key, typename Value>
+typename Db<Key, Value>::DbKey Db<Key, Value>::MakeDbKey(const Key& key) {
+  DbKey db_key;
+  key.ToFixedWidth(db_key.data());
+  return db_key;
 }
 
 // throws on level-db errors other than key not found
 template <typename Key, typename Value>
 Value Db<Key, Value>::Get(const Key& key) {
+  std::unique_ptr<Value> value(Read(key));
+  if (!value)
+    BOOST_THROW_EXCEPTION(MakeError(VaultErrors::no_such_account));
+  return std::move(*value);
+}
+
+template <typename Key, typename Value>
+std::shared_ptr<const Value> Db<Key, Value>::TryGet(const Key& key) {
+  if (kCacheCapacity_ == 0)
+    return std::shared_ptr<const Value>(Read(key));
+  uint64_t generation(0);
+  std::shared_ptr<const Value> value(FindInCache(key, generation));
+  if (value)
+    return value;
+  value = Read(key);
+  if (value)
+    AddToCache(key, value, generation);
+  return value;
+}
+
+template <typename Key, typename Value>
+typename Db<Key, Value>::CacheStats Db<Key, Value>::GetCacheStats() const {
+  std::lock_guard<std::mutex> lock(cache_mutex_);
+  return cache_stats_;
+}
+
+template <typename Key, typename Value>
+std::shared_ptr<const Value> Db<Key, Value>::FindInCache(const Key& key, uint64_t& generation) {
+  std::lock_guard<std::mutex> lock(cache_mutex_);
+  generation = cache_generation_;
+  auto itr(cache_index_.find(key));
+  if (itr == std::end(cache_index_)) {
+    ++cache_stats_.misses;
+    return nullptr;
+  }
+  ++cache_stats_.hits;
+  cache_list_.splice(std::begin(cache_list_), cache_list_, itr->second);
+  return itr->second->second;
+}
+
+template <typename Key, typename Value>
+void Db<Key, Value>::AddToCache(const Key& key, std::shared_ptr<const Value> value,
+                                uint64_t generation) {
+  std::lock_guard<std::mutex> lock(cache_mutex_);
+  if (generation == cache_generation_ && cache_index_.count(key) == 0)
+    InsertIntoCache(key, std::move(value));
+}
+
+template <typename Key, typename Value>
+void Db<Key, Value>::UpdateCache(const Key& key, std::shared_ptr<const Value> value) {
+  if (kCacheCapacity_ == 0)
+    return;
+  std::lock_guard<std::mutex> lock(cache_mutex_);
+  ++cache_generation_;
+  auto itr(cache_index_.find(key));
+  if (itr != std::end(cache_index_)) {
+    cache_list_.erase(itr->second);
+    cache_index_.erase(itr);
+  }
+  if (value) {
+    InsertIntoCache(key, std::move(value));
+  }
+}
+
+// cache_mutex_ must be locked
+template <typename Key, typename Value>
+void Db<Key, Value>::InsertIntoCache(const Key& key, std::shared_ptr<const Value> value) {
+  cache_list_.push_front(std::make_pair(key, std::move(value)));
+  cache_index_.insert(std::make_pair(key, std::begin(cache_list_)));
+  if (cache_list_.size() > kCacheCapacity_) {
+    cache_index_.erase(cache_list_.back().first);
+    cache_list_.pop_back();
+  }
+}
+
+template <typename Key, typename Value>
+std::unique_ptr<Value> Db<Key, Value>::Read(const Key& key,
+                                            std::vector<std::string>* operand_keys) {
+  const DbKey db_key(MakeDbKey(key));
+  if (!existence_filter_.MayContain(db_key))
+    return nullptr;
   leveldb::ReadOptions read_options;
-  read_options.verify_checksums = true;
+  read_options.verify_checksums = kVerifyChecksums_;
   std::string value_string;
-  leveldb::Status status(
-      leveldb_->Get(read_options, key.ToFixedWidthString().string(), &value_string));
+  if (detail::MergeOperator<Value>::kEnabled) {
+    // The value's merge operands sort directly after it, so are read by the same seek.
+    std::unique_ptr<leveldb::Iterator> db_iter(storage_engine_->NewIterator(read_options));
+    db_iter->Seek(db_key);
+    const bool found(detail::ReadMergedValue<Value>(*db_iter, db_key, value_string,
+                                                    operand_keys));
+    db_iter.reset();
+    return found ? std::unique_ptr<Value>(new Value(value_string)) : nullptr;
+  }
+  leveldb::Status status(storage_engine_->Get(read_options, db_key, &value_string));
   if (status.ok()) {
     assert(!value_string.empty());
-    return Value(value_string);
+    return std::unique_ptr<Value>(new Value(value_string));
   } else if (status.IsNotFound()) {
-    BOOST_THROW_EXCEPTION(MakeError(VaultErrors::no_such_account));
+    return nullptr;
   }
   BOOST_THROW_EXCEPTION(MakeError(VaultErrors::failed_to_handle_request));
 }
 
 template <typename Key, typename Value>
-void Db<Key, Value>::Put(const KvPair& key_value_pair) {
-  leveldb::Status status(leveldb_->Put(leveldb::WriteOptions(),
-                                       key_value_pair.first.ToFixedWidthString().string(),
-                                       key_value_pair.second.Serialise()));
-  if (!status.ok()) {
-    LOG(kError) << "Db<Key, Value>::Put incorrect leveldb::Status";
-    BOOST_THROW_EXCEPTION(MakeError(VaultErrors::failed_to_handle_request));
+bool Db<Key, Value>::Exists(const Key& key) {
+  const DbKey db_key(MakeDbKey(key));
+  if (!existence_filter_.MayContain(db_key))
+    return false;
+  std::unique_ptr<leveldb::Iterator> db_iter(storage_engine_->NewIterator(leveldb::ReadOptions()));
+  bool exists(false);
+  if (detail::MergeOperator<Value>::kEnabled) {
+    std::string value_string;
+    db_iter->Seek(db_key);
+    exists = detail::ReadMergedValue<Value>(*db_iter, db_key, value_string, nullptr);
+  } else {
+    exists = Contains(*db_iter, db_key);
   }
+  if (!db_iter->status().ok())
+    BOOST_THROW_EXCEPTION(MakeError(VaultErrors::failed_to_handle_request));
+  return exists;
 }
 
 template <typename Key, typename Value>
-void Db<Key, Value>::Delete(const Key& key) {
-  leveldb::Status status(
-      leveldb_->Delete(leveldb::WriteOptions(), key.ToFixedWidthString().string()));
-  if (!status.ok()) {
-    LOG(kError) << "Db<Key, Value>::Delete incorrect leveldb::Status";
-    BOOST_THROW_EXCEPTION(MakeError(VaultErrors::failed_to_handle_request));
-  }
+bool Db<Key, Value>::MayExist(const Key& key) const {
+  return existence_filter_.MayContain(MakeDbKey(key));
 }
 
 }  // namespace vault
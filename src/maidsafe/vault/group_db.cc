@@ -24,16 +24,16 @@ namespace vault {
 
 template <>
 GroupDb<PmidManager>::GroupMap::iterator GroupDb<PmidManager>::FindOrCreateGroup(
-    const GroupName& group_name) {
+    Shard& shard, const GroupName& group_name) {
   LOG(kVerbose) << "GroupDb<PmidManager>::FindOrCreateGroup " << HexSubstr(group_name->string());
   try {
-    return FindGroup(group_name);
+    return FindGroup(shard.group_map, group_name);
   } catch (const maidsafe_error& error) {
     LOG(kInfo) << "Account doesn't exist for group "
                << HexSubstr(group_name->string()) << ", error : "
                << boost::diagnostic_information(error)
                << ". -- Creating Account --";
-    return AddGroupToMap(group_name, Metadata(group_name));
+    return AddGroupToMap(shard, group_name, Metadata(group_name));
   }
 }
 
@@ -52,12 +52,12 @@ GroupDb<PmidManager>::GroupMap::iterator GroupDb<PmidManager>::FindOrCreateGroup
 
 // Deletes group if no further entry left in group
 template <>
-void GroupDb<PmidManager>::UpdateGroup(typename GroupMap::iterator it) {
+void GroupDb<PmidManager>::UpdateGroup(Shard& shard, typename GroupMap::iterator it) {
   LOG(kVerbose) << "GroupDb<PmidManager>::UpdateGroup " << HexSubstr(it->first->string());
   if (it->second.second.GroupStatus() == detail::GroupDbMetaDataStatus::kGroupEmpty) {
     LOG(kInfo) << "Account empty for group " << HexSubstr(it->first->string())
                << ". -- Deleteing Account --";
-    DeleteGroupEntries(it);
+    DeleteGroupEntries(shard, it);
   }
 }
 
@@ -20,6 +20,7 @@
 #define MAIDSAFE_VAULT_GROUP_DB_H_
 
 #include <algorithm>
+#include <array>
 #include <cstdint>
 #include <functional>
 #include <map>
@@ -32,20 +33,28 @@
 
 #include "boost/filesystem/operations.hpp"
 #include "boost/filesystem/path.hpp"
+#include "boost/thread/locks.hpp"
+#include "boost/thread/shared_mutex.hpp"
 #include "leveldb/db.h"
 
+#include "maidsafe/common/asio_service.h"
 #include "maidsafe/common/error.h"
 #include "maidsafe/common/on_scope_exit.h"
 #include "maidsafe/common/types.h"
 #include "maidsafe/vault/utils.h"
 #include "maidsafe/vault/config.h"
+#include "maidsafe/vault/parameters.h"
+#include "maidsafe/vault/storage_engine.h"
+#include "maidsafe/vault/group_db.pb.h"
 #include "maidsafe/vault/pmid_manager/pmid_manager.h"
 
 namespace maidsafe {
 
 namespace vault {
 
-// All public methods provide strong exception guarantee
+// All public methods provide strong exception guarantee.  Groups are spread over kShardCount_
+// shards by a hash of the group name, each shard having its own mutex, so operations on unrelated
+// groups don't contend.
 template <typename Persona>
 class GroupDb {
  public:
@@ -54,8 +63,21 @@ class GroupDb {
   typedef typename Persona::Value Value;
   typedef typename Persona::Metadata Metadata;
   typedef std::pair<Key, Value> KvPair;
+  typedef std::pair<Key, std::string> SerialisedKvPair;
   struct Contents;
-  typedef std::map<NodeId, std::vector<Contents>> TransferInfo;
+  // A group as transferred between holders.  Values are carried as stored, so the sender never
+  // parses them; the receiver parses just those it writes, to credit its metadata.  A large group
+  // is sent as several chunks, each carrying the group's metadata; 'continuation' is set on all but
+  // the first.
+  struct TransferContents {
+    TransferContents() : group_name(), metadata(), kv_pairs(), continuation(false) {}
+    GroupName group_name;
+    Metadata metadata;
+    std::vector<SerialisedKvPair> kv_pairs;
+    bool continuation;
+  };
+  typedef std::function<void(const NodeId& new_holder, std::vector<TransferContents> contents)>
+      TransferFunctor;
 
   struct Contents {
     Contents() : group_name(), metadata(), kv_pairs() {}
@@ -65,6 +87,7 @@ class GroupDb {
           metadata(std::move(other.metadata)),
           kv_pairs(std::move(other.kv_pairs))  {}
 
+
     GroupName group_name;
     Metadata metadata;
     std::vector<KvPair> kv_pairs;
@@ -72,7 +95,12 @@ class GroupDb {
     Contents(const Contents& other);
   };
 
-  GroupDb();
+  // If 'db_path' is empty, the db is created at a unique temporary path and destroyed along with
+  // this object.  Otherwise the db at 'db_path' is opened (or created if missing), the group map
+  // is recovered from it, and it is left on disk.  'db_options' chooses the storage engine; an
+  // in-memory engine never touches 'db_path'.
+  explicit GroupDb(const boost::filesystem::path& db_path = boost::filesystem::path(),
+                   const detail::DbOptions& db_options = detail::DbOptions());
   ~GroupDb();
 
   void AddGroup(const GroupName& group_name, const Metadata& metadata);
@@ -83,59 +111,140 @@ class GroupDb {
   // For atomically updating metadata and value
   std::unique_ptr<Value> Commit(const Key& key,
       std::function<detail::DbAction(Metadata& metadata, std::unique_ptr<Value>& value)> functor);
-  TransferInfo GetTransferInfo(std::shared_ptr<routing::MatrixChange> matrix_change);
-  void HandleTransfer(const std::vector<Contents>& contents);
+  // Appends 'operand' to the key's value without reading or parsing the value, and atomically
+  // applies 'functor' (if set) to the group's metadata.  Operands are folded in by
+  // detail::MergeOperator<Value>, in the order merged, whenever the value is read, committed or
+  // transferred.  Once Parameters::max_pending_merge_operands are pending, the next merge folds
+  // them and its own operand into the stored value, so reads never write.
+  void Merge(const Key& key, const std::string& operand,
+             std::function<void(Metadata& metadata)> functor = nullptr);
+  // Hands groups which have moved out of range to 'functor' in bounded batches, one batch per new
+  // holder at a time, and prunes groups still in range.
+  void GetTransferInfo(std::shared_ptr<routing::MatrixChange> matrix_change,
+                       TransferFunctor functor);
+  void HandleTransfer(const std::vector<TransferContents>& contents);
 
   // returns metadata if group_name exists in db
   Metadata GetMetadata(const GroupName& group_name);
-  // returns value if key exists in db
+  // returns value if key exists in db.  Reads from a db snapshot without holding the group's
+  // mutex, so doesn't wait for commits or transfer scans on that group.
   Value GetValue(const Key& key);
+  // As GetValue, but returns null rather than throwing if the group or key doesn't exist
+  std::unique_ptr<Value> TryGetValue(const Key& key);
+  // Checks for the key without reading or parsing its value.  Throws only on db errors.
+  bool Exists(const Key& key);
   Contents GetContents(const GroupName& group_name);
+  // Calls 'functor' with each of the group's keys, without copying or parsing their values.  The
+  // scan reads a snapshot without holding any lock, so 'functor' may call back into this db.
+  // Throws no_such_account if the group doesn't exist.
+  void ForEachKey(const GroupName& group_name, std::function<void(const Key& key)> functor);
 
  private:
   typedef uint32_t GroupId;
   typedef std::map<GroupName, std::pair<GroupId, Metadata>> GroupMap;
+  static const int kPrefixWidth_ = detail::GroupDbPrefixWidth::value;
+  // Size of every db key other than a group's metadata entry or a merge operand
+  static const size_t kLevelDbKeySize_ = kPrefixWidth_ + Key::kFixedWidthSize;
+  // Keys are encoded into these stack buffers, so building or decoding one doesn't allocate.
+  typedef detail::FixedWidthKey<kLevelDbKeySize_> LevelDbKey;
+  typedef detail::FixedWidthKey<kPrefixWidth_> GroupPrefix;
+
+  // 'mutex' serialises all operations on the shard's groups.  'map_mutex' is additionally locked
+  // exclusively only while inserting into or erasing from 'group_map', so GetValue can look up a
+  // group id under a shared lock without waiting for in-flight commits or transfer scans.
+  struct Shard {
+    Shard() : mutex(), map_mutex(), group_map() {}
+    std::mutex mutex;
+    boost::shared_mutex map_mutex;
+    GroupMap group_map;
+  };
+
   GroupDb(const GroupDb&);
   GroupDb& operator=(const GroupDb&);
   GroupDb(GroupDb&&);
   GroupDb& operator=(GroupDb&&);
 
-  typename GroupMap::iterator AddGroupToMap(const GroupName& group_name, const Metadata& metadata);
-  void UpdateGroup(typename GroupMap::iterator itr);
-
-  void DeleteGroupEntries(const GroupName& group_name);
-  void DeleteGroupEntries(typename GroupMap::iterator itr);
+  Shard& GetShard(const GroupName& group_name);
+  typename GroupMap::iterator AddGroupToMap(Shard& shard, const GroupName& group_name,
+                                            const Metadata& metadata);
+  void EraseGroup(Shard& shard, typename GroupMap::iterator it);
+  GroupId AllocateGroupId();
+  void ReleaseGroupId(const GroupId& group_id);
+  void UpdateGroup(Shard& shard, typename GroupMap::iterator itr);
+
+  void DeleteGroupEntries(Shard& shard, const GroupName& group_name);
+  void DeleteGroupEntries(Shard& shard, typename GroupMap::iterator itr);
+  void DeleteRange(const GroupId& group_id);
+  void ScheduleCompaction(const GroupId& group_id);
+  void CompactPendingRanges();
   Contents GetContents(typename GroupMap::iterator it);
-  void ApplyTransfer(const Contents& /*contents*/);
-  Value Get(const Key& key, const GroupId& group_id);
-  void Put(const KvPair& key_value_pair, const GroupId& group_id);
-  void Delete(const Key& key, const GroupId& group_id);
-  std::string MakeLevelDbKey(const GroupId& group_id, const Key& key);
-  Key MakeKey(const GroupName group_name, const leveldb::Slice& level_db_key);
-  uint32_t GetGroupId(const leveldb::Slice& level_db_key) const;
-  typename GroupMap::iterator FindGroup(const GroupName& group_name);
-  typename GroupMap::iterator FindOrCreateGroup(const GroupName& group_name);
-
-  static const int kPrefixWidth_ = 2;
+  void ApplyTransfer(Shard& shard, const TransferContents& contents);
+  void LoadGroupMap();
+  std::string SerialiseMetadataEntry(typename GroupMap::const_iterator it) const;
+  void PutMetadata(typename GroupMap::const_iterator it);
+  std::unique_ptr<Value> TryGet(const Key& key, const GroupId& group_id,
+                                const leveldb::Snapshot* snapshot = nullptr,
+                                std::vector<std::string>* operand_keys = nullptr);
+  // Adds to 'batch_writer' the writes replacing the value's pending merge operands with the value
+  // they and 'operand' fold to.  Must be called with the group's shard mutex held.
+  void FoldMergeOperands(const Key& key, const GroupId& group_id, const std::string& operand,
+                         detail::DbBatchWriter& batch_writer);
+  bool FindGroupIdAndSnapshot(const GroupName& group_name, GroupId& group_id,
+                              const leveldb::Snapshot*& snapshot);
+  static LevelDbKey MakeLevelDbKey(const GroupId& group_id, const Key& key);
+  // The group's metadata is stored under its bare prefix, which also begins each of its keys.
+  static GroupPrefix MakeGroupPrefix(const GroupId& group_id);
+  static Key MakeKey(const GroupName group_name, const leveldb::Slice& level_db_key);
+  static GroupId GetGroupId(const leveldb::Slice& level_db_key);
+  typename GroupMap::iterator FindGroup(GroupMap& group_map, const GroupName& group_name);
+  typename GroupMap::iterator FindOrCreateGroup(Shard& shard, const GroupName& group_name);
+
+  static const uint64_t kGroupsLimit_ = 1ULL << (8 * kPrefixWidth_);
+  static const size_t kShardCount_ = 16;
+  const bool kPersistent_;
   const boost::filesystem::path kDbPath_;
-  std::mutex mutex_;
-  std::unique_ptr<leveldb::DB> leveldb_;
-  GroupMap group_map_;
+  const bool kVerifyChecksums_;
+  std::unique_ptr<detail::StorageEngine> storage_engine_;
+  std::array<Shard, kShardCount_> shards_;
+  // Guards the group id allocator.  May be locked while holding a shard's mutex, never the other
+  // way round.  Released ids are recycled from 'free_group_ids_' before 'next_group_id_' is
+  // advanced, so allocation and release are both constant time.
+  std::mutex group_ids_mutex_;
+  uint64_t next_group_id_;
+  std::vector<GroupId> free_group_ids_;
+  // Serialises GetTransferInfo calls.  Shard mutexes are only held one at a time while scanning.
+  std::mutex transfer_mutex_;
+  // Ranges of deleted groups awaiting compaction.  A single task at a time is posted to
+  // 'compaction_service_' to compact everything pending, so a burst of deletions is coalesced.
+  std::mutex compaction_mutex_;
+  std::vector<GroupId> pending_compactions_;
+  bool compaction_scheduled_;
+  AsioService compaction_service_;
 };
 
 template <>
 GroupDb<PmidManager>::GroupMap::iterator GroupDb<PmidManager>::FindOrCreateGroup(
-    const GroupName& group_name);
+    Shard& shard, const GroupName& group_name);
 
 template <>
-void GroupDb<PmidManager>::UpdateGroup(typename GroupMap::iterator itr);
+void GroupDb<PmidManager>::UpdateGroup(Shard& shard, typename GroupMap::iterator itr);
 
 template <typename Persona>
-GroupDb<Persona>::GroupDb()
-    : kDbPath_(boost::filesystem::unique_path()),
-      mutex_(),
-      leveldb_(InitialiseLevelDb(kDbPath_)),
-      group_map_() {
+GroupDb<Persona>::GroupDb(const boost::filesystem::path& db_path,
+                          const detail::DbOptions& db_options)
+    : kPersistent_(!db_path.empty()),
+      kDbPath_(kPersistent_ ? db_path : boost::filesystem::unique_path()),
+      kVerifyChecksums_(db_options.verify_checksums),
+      storage_engine_(detail::InitialiseStorageEngine(kDbPath_, kPersistent_, db_options)),
+      shards_(),
+      group_ids_mutex_(),
+      next_group_id_(0),
+      free_group_ids_(),
+      transfer_mutex_(),
+      compaction_mutex_(),
+      pending_compactions_(),
+      compaction_scheduled_(false),
+      compaction_service_(1) {
 #if defined(__GNUC__) && (!defined(MAIDSAFE_APPLE) && !(defined(_MSC_VER) && _MSC_VER == 1700))
   // Remove this assert if value needs to be copy constructible.
   // this is just a check to avoid copy constructor unless we require it
@@ -147,52 +256,88 @@ GroupDb<Persona>::GroupDb()
   static_assert(std::is_move_constructible<typename Persona::Value>::value,
                 "value should be move constructible !");
 #endif
+  if (kPersistent_)
+    LoadGroupMap();
 }
 
 template <typename Persona>
 GroupDb<Persona>::~GroupDb() {
-  try {
-    leveldb::DestroyDB(kDbPath_.string(), leveldb::Options());
-    boost::filesystem::remove_all(kDbPath_);
-  } catch (const std::exception& e) {
-    LOG (kError) << "Failed to remove db : " << boost::diagnostic_information(e);
-  }
+  compaction_service_.Stop();
+}
+
+template <typename Persona>
+typename GroupDb<Persona>::Shard& GroupDb<Persona>::GetShard(const GroupName& group_name) {
+  return shards_[std::hash<std::string>()(group_name->string()) % kShardCount_];
 }
 
 template <typename Persona>
 void GroupDb<Persona>::AddGroup(const GroupName& group_name, const Metadata& metadata) {
-  std::lock_guard<std::mutex> lock(mutex_);
-  AddGroupToMap(group_name, metadata);
+  auto& shard(GetShard(group_name));
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto it(AddGroupToMap(shard, group_name, metadata));
+  try {
+    PutMetadata(it);
+  } catch (const maidsafe_error&) {
+    EraseGroup(shard, it);
+    throw;
+  }
 }
 
 template <typename Persona>
 typename GroupDb<Persona>::GroupMap::iterator GroupDb<Persona>::AddGroupToMap(
-    const GroupName& group_name, const Metadata& metadata) {
-  static const uint64_t kGroupsLimit(static_cast<GroupId>(std::pow(256, kPrefixWidth_)));
-  if (group_map_.size() == kGroupsLimit - 1)
-    BOOST_THROW_EXCEPTION(MakeError(VaultErrors::failed_to_handle_request));
-  GroupId group_id(RandomInt32() % kGroupsLimit);
-  while (std::any_of(std::begin(group_map_), std::end(group_map_),
-                     [&group_id](const std::pair<GroupName, std::pair<GroupId, Metadata>>&
-                                 element) { return group_id == element.second.first; })) {
-    group_id = RandomInt32() % kGroupsLimit;
-  }
-  LOG(kVerbose) << "GroupDb<Persona>::AddGroupToMap size of group_map_ " << group_map_.size()
-                << " current group_name " << HexSubstr(group_name->string());
-  auto ret_val = group_map_.insert(std::make_pair(group_name, std::make_pair(group_id, metadata)));
-  if (!ret_val.second) {
+    Shard& shard, const GroupName& group_name, const Metadata& metadata) {
+  if (shard.group_map.count(group_name) != 0) {
     LOG(kError) << "account already exists in the group map";
     BOOST_THROW_EXCEPTION(MakeError(VaultErrors::account_already_exists));
   }
+  const GroupId group_id(AllocateGroupId());
+  LOG(kVerbose) << "GroupDb<Persona>::AddGroupToMap size of group_map " << shard.group_map.size()
+                << " current group_name " << HexSubstr(group_name->string());
+  boost::unique_lock<boost::shared_mutex> map_lock(shard.map_mutex);
+  auto ret_val = shard.group_map.insert(std::make_pair(group_name,
+                                                       std::make_pair(group_id, metadata)));
   LOG(kInfo) << "group inserting succeeded for group_name "
              << HexSubstr(group_name->string());
   return ret_val.first;
 }
 
+template <typename Persona>
+void GroupDb<Persona>::EraseGroup(Shard& shard, typename GroupMap::iterator it) {
+  const GroupId group_id(it->second.first);
+  {
+    boost::unique_lock<boost::shared_mutex> map_lock(shard.map_mutex);
+    shard.group_map.erase(it);
+  }
+  ReleaseGroupId(group_id);
+}
+
+template <typename Persona>
+typename GroupDb<Persona>::GroupId GroupDb<Persona>::AllocateGroupId() {
+  std::lock_guard<std::mutex> lock(group_ids_mutex_);
+  if (!free_group_ids_.empty()) {
+    const GroupId group_id(free_group_ids_.back());
+    free_group_ids_.pop_back();
+    return group_id;
+  }
+  if (next_group_id_ == kGroupsLimit_) {
+    LOG(kError) << "GroupDb<Persona>::AllocateGroupId all " << kGroupsLimit_
+                << " group ids are in use";
+    BOOST_THROW_EXCEPTION(MakeError(VaultErrors::failed_to_handle_request));
+  }
+  return static_cast<GroupId>(next_group_id_++);
+}
+
+template <typename Persona>
+void GroupDb<Persona>::ReleaseGroupId(const GroupId& group_id) {
+  std::lock_guard<std::mutex> lock(group_ids_mutex_);
+  free_group_ids_.push_back(group_id);
+}
+
 template <typename Persona>
 void GroupDb<Persona>::DeleteGroup(const GroupName& group_name) {
-  std::lock_guard<std::mutex> lock(mutex_);
-  DeleteGroupEntries(group_name);
+  auto& shard(GetShard(group_name));
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  DeleteGroupEntries(shard, group_name);
 }
 
 template <typename Persona>
@@ -201,10 +346,12 @@ void GroupDb<Persona>::Commit(const GroupName& group_name,
   LOG(kVerbose) << "GroupDb<Persona>::Commit update metadata for account "
                 << HexSubstr(group_name->string());
   assert(functor);
-  std::lock_guard<std::mutex> lock(mutex_);
-  const auto it(FindOrCreateGroup(group_name));
-  on_scope_exit update_group([it, this]() { UpdateGroup(it); });
+  auto& shard(GetShard(group_name));
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  const auto it(FindOrCreateGroup(shard, group_name));
+  on_scope_exit update_group([it, &shard, this]() { UpdateGroup(shard, it); });
   functor(it->second.second);
+  PutMetadata(it);
 }
 
 template <typename Persona>
@@ -214,47 +361,94 @@ std::unique_ptr<typename Persona::Value> GroupDb<Persona>::Commit(
   LOG(kVerbose) << "GroupDb<Persona>::Commit update metadata and value for account "
                 << HexSubstr(key.group_name()->string());
   assert(functor);
-  std::lock_guard<std::mutex> lock(mutex_);
-  const auto it(FindOrCreateGroup(key.group_name()));
-  on_scope_exit update_group([it, this]() { UpdateGroup(it); });
-  std::unique_ptr<Value> value;
-  try {
-    value.reset(new Value(Get(key, it->second.first)));
-  } catch (const maidsafe_error& error) {
-    LOG(kError) << "GroupDb<Persona>::Commit encountered error "
-                << boost::diagnostic_information(error);
-    if (error.code() != make_error_code(CommonErrors::no_such_element))
-      throw error;  // throw only for db errors
-  }
+  auto& shard(GetShard(key.group_name()));
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  const auto it(FindOrCreateGroup(shard, key.group_name()));
+  on_scope_exit update_group([it, &shard, this]() { UpdateGroup(shard, it); });
+  std::vector<std::string> operand_keys;
+  std::unique_ptr<Value> value(TryGet(key, it->second.first, nullptr, &operand_keys));
 
   try {
+    // The value, the removal of any merge operands folded into it and the group's metadata are
+    // written in a single batch.
+    detail::DbBatchWriter batch_writer(*storage_engine_);
+    for (const auto& operand_key : operand_keys)
+      batch_writer.Delete(operand_key);
     if (detail::DbAction::kPut == functor(it->second.second, value)) {
       LOG(kInfo) << "detail::DbAction::kPut";
       assert(value);
       if (!value)
         BOOST_THROW_EXCEPTION(MakeError(CommonErrors::null_pointer));
-      Put(std::make_pair(key, std::move(*value)), it->second.first);
+      batch_writer.Put(MakeLevelDbKey(it->second.first, key), value->Serialise());
+      value.reset();
     } else {
       LOG(kInfo) << "detail::DbAction::kDelete";
-      if (value) {
-        Delete(key, it->second.first);
-        return value;
-      } else {
+      // A stored value may have been emptied by its merge operands, so is deleted regardless.
+      batch_writer.Delete(MakeLevelDbKey(it->second.first, key));
+      if (!value && operand_keys.empty())
         LOG(kError) << "value is not initialised";
-      }
     }
+    batch_writer.Put(MakeGroupPrefix(it->second.first),
+                     SerialiseMetadataEntry(it));
+    batch_writer.Flush();
   } catch (const maidsafe_error& error) {
     LOG(kError) << "GroupDb<Persona>::Commit encountered error "
                 << boost::diagnostic_information(error);
     throw error;
   }
-  return nullptr;
+  return value;
+}
+
+template <typename Persona>
+void GroupDb<Persona>::Merge(const Key& key, const std::string& operand,
+                             std::function<void(Metadata& metadata)> functor) {
+  static_assert(detail::MergeOperator<Value>::kEnabled, "Value doesn't support merges");
+  auto& shard(GetShard(key.group_name()));
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  const size_t group_count(shard.group_map.size());
+  const auto it(FindOrCreateGroup(shard, key.group_name()));
+  const bool group_created(shard.group_map.size() != group_count);
+  on_scope_exit update_group([it, &shard, this]() { UpdateGroup(shard, it); });
+  const LevelDbKey level_db_key(MakeLevelDbKey(it->second.first, key));
+  std::unique_ptr<leveldb::Iterator> db_iter(storage_engine_->NewIterator(leveldb::ReadOptions()));
+  const uint64_t sequence(detail::NextMergeSequence(*db_iter, level_db_key));
+  db_iter.reset();
+  detail::DbBatchWriter batch_writer(*storage_engine_);
+  if (sequence >= Parameters::max_pending_merge_operands)
+    FoldMergeOperands(key, it->second.first, operand, batch_writer);
+  else
+    batch_writer.Put(detail::MakeMergeOperandKey(level_db_key, sequence), operand);
+  if (functor)
+    functor(it->second.second);
+  // A group created here needs its metadata entry too, else LoadGroupMap drops it as an orphan.
+  if (functor || group_created)
+    batch_writer.Put(MakeGroupPrefix(it->second.first), SerialiseMetadataEntry(it));
+  batch_writer.Flush();
+}
+
+template <typename Persona>
+void GroupDb<Persona>::FoldMergeOperands(const Key& key, const GroupId& group_id,
+                                         const std::string& operand,
+                                         detail::DbBatchWriter& batch_writer) {
+  LOG(kVerbose) << "GroupDb<Persona>::FoldMergeOperands for account "
+                << HexSubstr(key.group_name()->string());
+  std::vector<std::string> operand_keys;
+  std::unique_ptr<Value> value(TryGet(key, group_id, nullptr, &operand_keys));
+  if (detail::MergeOperator<Value>::Apply(operand, value) == detail::DbAction::kDelete)
+    value.reset();
+  for (const auto& operand_key : operand_keys)
+    batch_writer.Delete(operand_key);
+  if (value)
+    batch_writer.Put(MakeLevelDbKey(group_id, key), value->Serialise());
+  else
+    batch_writer.Delete(MakeLevelDbKey(group_id, key));
 }
 
 template <typename Persona>
 typename GroupDb<Persona>::Contents GroupDb<Persona>::GetContents(const GroupName& group_name) {
-  std::lock_guard<std::mutex> lock(mutex_);
-  auto it(FindGroup(group_name));
+  auto& shard(GetShard(group_name));
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto it(FindGroup(shard.group_map, group_name));
   return GetContents(it);
 }
 
@@ -264,86 +458,355 @@ typename GroupDb<Persona>::Contents GroupDb<Persona>::GetContents(typename Group
   contents.group_name = it->first;
   contents.metadata = it->second.second;
   // get db entry
-  std::unique_ptr<leveldb::Iterator> iter(leveldb_->NewIterator(leveldb::ReadOptions()));
+  std::unique_ptr<leveldb::Iterator> iter(storage_engine_->NewIterator(leveldb::ReadOptions()));
   const auto group_id = it->second.first;
-  const auto group_id_str = detail::ToFixedWidthString<kPrefixWidth_>(group_id);
-  for (iter->Seek(group_id_str); (iter->Valid() && (GetGroupId(iter->key()) == group_id));
-       iter->Next()) {
-    contents.kv_pairs.push_back(std::make_pair(MakeKey(contents.group_name, iter->key()),
-                                               Value(iter->value().ToString())));
+  // Each step consumes a value along with any merge operands stored after it.
+  iter->Seek(MakeGroupPrefix(group_id));
+  while (iter->Valid() && (GetGroupId(iter->key()) == group_id)) {
+    if (iter->key().size() == kPrefixWidth_) {
+      iter->Next();
+      continue;  // the group's metadata entry
+    }
+    // Copied, as reading the value moves the iterator on.
+    const LevelDbKey level_db_key(iter->key());
+    std::string value_string;
+    if (detail::ReadMergedValue<Value>(*iter, level_db_key, value_string, nullptr)) {
+      contents.kv_pairs.push_back(std::make_pair(MakeKey(contents.group_name, level_db_key),
+                                                 Value(value_string)));
+    }
   }
   iter.reset();
   return contents;
 }
 
 template <typename Persona>
-typename GroupDb<Persona>::TransferInfo GroupDb<Persona>::GetTransferInfo(
-    std::shared_ptr<routing::MatrixChange> matrix_change) {
-  std::lock_guard<std::mutex> lock(mutex_);
-  std::vector<GroupName> prune_vector;
-  TransferInfo transfer_info;
-  for (auto group_itr(group_map_.begin()); group_itr != group_map_.end(); ++group_itr) {
-    auto check_holder_result = matrix_change->CheckHolders(NodeId(group_itr->first->string()));
-    if (check_holder_result.proximity_status != routing::GroupRangeStatus::kInRange) {
-      if (check_holder_result.new_holders.size() != 0) {
-        assert(check_holder_result.new_holders.size() == 1);
-        auto found_itr = transfer_info.find(check_holder_result.new_holders.at(0));
-        if (found_itr != transfer_info.end()) {  // Add to map
-          found_itr->second.push_back(GetContents(group_itr));
-        } else {  // create contents add to map
-          std::vector<Contents>  contents_vector;
-          contents_vector.push_back(std::move(GetContents(group_itr)));
-          transfer_info[check_holder_result.new_holders.at(0)] = std::move(contents_vector);
+void GroupDb<Persona>::ForEachKey(const GroupName& group_name,
+                                  std::function<void(const Key& key)> functor) {
+  assert(functor);
+  GroupId group_id(0);
+  const leveldb::Snapshot* snapshot(nullptr);
+  if (!FindGroupIdAndSnapshot(group_name, group_id, snapshot))
+    BOOST_THROW_EXCEPTION(MakeError(VaultErrors::no_such_account));
+  on_scope_exit release_snapshot([snapshot, this]() {
+    storage_engine_->ReleaseSnapshot(snapshot);
+  });
+  leveldb::ReadOptions read_options;
+  read_options.snapshot = snapshot;
+  // A one-off scan of a whole group shouldn't evict frequently read blocks.
+  read_options.fill_cache = false;
+  std::unique_ptr<leveldb::Iterator> iter(storage_engine_->NewIterator(read_options));
+  iter->Seek(MakeGroupPrefix(group_id));
+  while (iter->Valid() && (GetGroupId(iter->key()) == group_id)) {
+    if (iter->key().size() == kPrefixWidth_) {
+      iter->Next();
+      continue;  // the group's metadata entry
+    }
+    const LevelDbKey level_db_key(iter->key());
+    if (detail::MergeOperator<Value>::kEnabled) {
+      // Pending merge operands decide whether the value exists, so have to be folded.
+      std::string value_string;
+      if (!detail::ReadMergedValue<Value>(*iter, level_db_key, value_string, nullptr))
+        continue;
+    } else {
+      iter->Next();
+    }
+    functor(MakeKey(group_name, level_db_key));
+  }
+  if (!iter->status().ok())
+    BOOST_THROW_EXCEPTION(MakeError(VaultErrors::failed_to_handle_request));
+}
+
+// Shards are scanned one at a time, and each group is looked up and pruned under its shard's
+// mutex.  A transferred group's entries are then read from a leveldb iterator without any mutex
+// held, and handed to 'functor' in chunks, so at most Parameters::max_transfer_batch_count kv
+// pairs are buffered at once.  A large group may therefore arrive at its new holder as several
+// Contents, each carrying the group's metadata.
+template <typename Persona>
+void GroupDb<Persona>::GetTransferInfo(std::shared_ptr<routing::MatrixChange> matrix_change,
+                                       TransferFunctor functor) {
+  assert(functor);
+  std::lock_guard<std::mutex> transfer_lock(transfer_mutex_);
+  std::map<NodeId, std::vector<TransferContents>> batches;
+  size_t batched_count(0);
+  auto flush_batches([&] {
+    for (auto& batch : batches)
+      functor(batch.first, std::move(batch.second));
+    batches.clear();
+    batched_count = 0;
+  });
+
+  for (auto& shard : shards_) {
+    std::vector<GroupName> group_names;
+    {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      for (const auto& group : shard.group_map)
+        group_names.push_back(group.first);
+    }
+    for (const auto& group_name : group_names) {
+      auto check_holder_result = matrix_change->CheckHolders(NodeId(group_name->string()));
+      if (check_holder_result.proximity_status == routing::GroupRangeStatus::kInRange) {
+        std::lock_guard<std::mutex> lock(shard.mutex);  // Prune group
+        DeleteGroupEntries(shard, group_name);
+        continue;
+      }
+      if (check_holder_result.new_holders.size() == 0)
+        continue;
+      assert(check_holder_result.new_holders.size() == 1);
+      const NodeId new_holder(check_holder_result.new_holders.at(0));
+
+      TransferContents contents;
+      GroupId group_id(0);
+      std::unique_ptr<leveldb::Iterator> iter;
+      {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it(shard.group_map.find(group_name));
+        if (it == shard.group_map.end())
+          continue;  // deleted since the group names were gathered
+        contents.group_name = group_name;
+        contents.metadata = it->second.second;
+        group_id = it->second.first;
+        iter.reset(storage_engine_->NewIterator(leveldb::ReadOptions()));
+        iter->Seek(MakeGroupPrefix(group_id));
+      }
+      bool chunk_handed_on(false);
+      while (iter->Valid() && (GetGroupId(iter->key()) == group_id)) {
+        if (iter->key().size() == kPrefixWidth_) {
+          iter->Next();
+          continue;  // the group's metadata entry
+        }
+        const LevelDbKey level_db_key(iter->key());
+        std::string value_string;
+        if (!detail::ReadMergedValue<Value>(*iter, level_db_key, value_string, nullptr))
+          continue;
+        contents.kv_pairs.push_back(std::make_pair(MakeKey(group_name, level_db_key),
+                                                   std::move(value_string)));
+        if (++batched_count == Parameters::max_transfer_batch_count) {
+          TransferContents chunk;
+          chunk.group_name = group_name;
+          chunk.metadata = contents.metadata;
+          chunk.kv_pairs.swap(contents.kv_pairs);
+          chunk.continuation = chunk_handed_on;
+          batches[new_holder].push_back(std::move(chunk));
+          flush_batches();
+          chunk_handed_on = true;
         }
       }
-    } else {  // Prune group
-      prune_vector.push_back(group_itr->first);
+      if (!iter->status().ok())
+        BOOST_THROW_EXCEPTION(MakeError(VaultErrors::failed_to_handle_request));
+      iter.reset();
+      // An empty group is still transferred, for the sake of its metadata.
+      if (!contents.kv_pairs.empty() || !chunk_handed_on) {
+        contents.continuation = chunk_handed_on;
+        batches[new_holder].push_back(std::move(contents));
+        if (++batched_count >= Parameters::max_transfer_batch_count)
+          flush_batches();
+      }
     }
   }
-
-  for (const auto& i : prune_vector)
-    DeleteGroupEntries(i);
-  return transfer_info;
+  flush_batches();
 }
 
 // FIXME (Prakash)
 template <typename Persona>
-void GroupDb<Persona>::HandleTransfer(const std::vector<Contents>& contents_vector) {
-  std::lock_guard<std::mutex> lock(mutex_);
+void GroupDb<Persona>::HandleTransfer(const std::vector<TransferContents>& contents_vector) {
   for (const auto& contents : contents_vector) {
-    ApplyTransfer(contents);
+    auto& shard(GetShard(contents.group_name));
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    ApplyTransfer(shard, contents);
   }
 }
 
-// Ignores values which are already in db ?
-// Need discussion related to pmid account creation case. Pmid account will be created on
-// put action. This means a valid account transfer will be ignored.
+// The metadata entry goes in the final batch, so an interrupted transfer leaves no group behind
+// on recovery.  A group already held here may have been created independently (e.g. a PmidManager
+// account created on put), so every chunk writes only the entries it lacks, and only those are
+// credited to its metadata.  The sender's metadata contributes just its account-wide state, which
+// a new group starts from and an existing one merges in from the first chunk.
 template <typename Persona>
-void GroupDb<Persona>::ApplyTransfer(const Contents& contents) {
-  auto itr = AddGroupToMap(contents.group_name, contents.metadata);
-  for (const auto& kv_pair : contents.kv_pairs)
-    Put(kv_pair, itr->second.first);
+void GroupDb<Persona>::ApplyTransfer(Shard& shard, const TransferContents& contents) {
+  auto itr(shard.group_map.find(contents.group_name));
+  const bool created(itr == shard.group_map.end());
+  if (created) {
+    Metadata metadata;
+    metadata.Merge(contents.metadata);
+    itr = AddGroupToMap(shard, contents.group_name, metadata);
+  }
+  const GroupId group_id(itr->second.first);
+  const Metadata previous_metadata(itr->second.second);
+  try {
+    if (!created && !contents.continuation)
+      itr->second.second.Merge(contents.metadata);
+    detail::DbBatchWriter batch_writer(*storage_engine_);
+    std::unique_ptr<leveldb::Iterator> iter(storage_engine_->NewIterator(leveldb::ReadOptions()));
+    for (const auto& kv_pair : contents.kv_pairs) {
+      const LevelDbKey level_db_key(MakeLevelDbKey(group_id, kv_pair.first));
+      iter->Seek(level_db_key);
+      if (iter->Valid() && iter->key().starts_with(level_db_key))
+        continue;
+      batch_writer.Put(level_db_key, kv_pair.second);
+      itr->second.second.AddTransferredValue(Value(kv_pair.second));
+    }
+    if (!iter->status().ok())
+      BOOST_THROW_EXCEPTION(MakeError(VaultErrors::failed_to_handle_request));
+    iter.reset();
+    batch_writer.Put(MakeGroupPrefix(group_id), SerialiseMetadataEntry(itr));
+    batch_writer.Flush();
+  } catch (const maidsafe_error&) {
+    if (created)
+      EraseGroup(shard, itr);
+    else
+      itr->second.second = previous_metadata;
+    throw;
+  }
+}
+
+// Each group's metadata is stored under the bare group id prefix, so recovery only needs to read
+// the first entry of each group's range before skipping to the next group id.
+template <typename Persona>
+void GroupDb<Persona>::LoadGroupMap() {
+  std::vector<GroupId> used_group_ids, orphaned_group_ids;
+  std::unique_ptr<leveldb::Iterator> iter(storage_engine_->NewIterator(leveldb::ReadOptions()));
+  iter->SeekToFirst();
+  while (iter->Valid()) {
+    const GroupId group_id(GetGroupId(iter->key()));
+    if (iter->key().size() == kPrefixWidth_) {
+      protobuf::GroupDbMetadataEntry entry;
+      if (!entry.ParseFromString(iter->value().ToString()))
+        BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+      const GroupName group_name(Identity(entry.group_name()));
+      GetShard(group_name).group_map.insert(std::make_pair(group_name,
+          std::make_pair(group_id, Metadata(entry.serialised_metadata()))));
+      used_group_ids.push_back(group_id);
+    } else {
+      LOG(kWarning) << "GroupDb<Persona>::LoadGroupMap group id " << group_id
+                    << " has entries but no metadata; removing them";
+      orphaned_group_ids.push_back(group_id);
+    }
+    next_group_id_ = static_cast<uint64_t>(group_id) + 1;
+    if (next_group_id_ == kGroupsLimit_)
+      break;
+    iter->Seek(MakeGroupPrefix(group_id + 1));
+  }
+  if (!iter->status().ok())
+    BOOST_THROW_EXCEPTION(MakeError(VaultErrors::failed_to_handle_request));
+  iter.reset();
+  for (const auto& group_id : orphaned_group_ids)
+    DeleteRange(group_id);
+  // Ids below the high-water mark which aren't in use ('used_group_ids' is sorted, since keys are
+  // big-endian) go on the free list.
+  auto used_itr(std::begin(used_group_ids));
+  for (uint64_t group_id(0); group_id != next_group_id_; ++group_id) {
+    if (used_itr != std::end(used_group_ids) && *used_itr == group_id)
+      ++used_itr;
+    else
+      free_group_ids_.push_back(static_cast<GroupId>(group_id));
+  }
+  LOG(kInfo) << "GroupDb<Persona>::LoadGroupMap recovered " << used_group_ids.size()
+             << " groups from " << kDbPath_;
+}
+
+template <typename Persona>
+std::string GroupDb<Persona>::SerialiseMetadataEntry(
+    typename GroupMap::const_iterator it) const {
+  protobuf::GroupDbMetadataEntry entry;
+  entry.set_group_name(it->first->string());
+  entry.set_serialised_metadata(it->second.second.Serialise());
+  return entry.SerializeAsString();
+}
+
+template <typename Persona>
+void GroupDb<Persona>::PutMetadata(typename GroupMap::const_iterator it) {
+  leveldb::Status status(
+      storage_engine_->Put(MakeGroupPrefix(it->second.first),
+                           SerialiseMetadataEntry(it)));
+  if (!status.ok())
+    BOOST_THROW_EXCEPTION(MakeError(VaultErrors::failed_to_handle_request));
 }
 
 template <typename Persona>
 typename GroupDb<Persona>::Metadata GroupDb<Persona>::GetMetadata(const GroupName& group_name) {
-  std::lock_guard<std::mutex> lock(mutex_);
-  auto it(FindGroup(group_name));
+  auto& shard(GetShard(group_name));
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto it(FindGroup(shard.group_map, group_name));
   return it->second.second;
 }
 
 
 template <typename Persona>
 typename GroupDb<Persona>::Value GroupDb<Persona>::GetValue(const Key& key) {
-  std::lock_guard<std::mutex> lock(mutex_);
-  auto it(FindGroup(key.group_name()));
-  return Get(key, it->second.first);
+  GroupId group_id(0);
+  const leveldb::Snapshot* snapshot(nullptr);
+  if (!FindGroupIdAndSnapshot(key.group_name(), group_id, snapshot))
+    BOOST_THROW_EXCEPTION(MakeError(VaultErrors::no_such_account));
+  on_scope_exit release_snapshot([snapshot, this]() {
+    storage_engine_->ReleaseSnapshot(snapshot);
+  });
+  std::unique_ptr<Value> value(TryGet(key, group_id, snapshot));
+  if (!value) {
+    LOG(kWarning) << "cann't find such element for get, throwing error";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::no_such_element));
+  }
+  return std::move(*value);
+}
+
+template <typename Persona>
+std::unique_ptr<typename Persona::Value> GroupDb<Persona>::TryGetValue(const Key& key) {
+  GroupId group_id(0);
+  const leveldb::Snapshot* snapshot(nullptr);
+  if (!FindGroupIdAndSnapshot(key.group_name(), group_id, snapshot))
+    return nullptr;
+  on_scope_exit release_snapshot([snapshot, this]() {
+    storage_engine_->ReleaseSnapshot(snapshot);
+  });
+  std::unique_ptr<Value> value(TryGet(key, group_id, snapshot));
+  return value;
 }
 
 template <typename Persona>
-void GroupDb<Persona>::DeleteGroupEntries(const GroupName& group_name) {
+bool GroupDb<Persona>::Exists(const Key& key) {
+  GroupId group_id(0);
+  const leveldb::Snapshot* snapshot(nullptr);
+  if (!FindGroupIdAndSnapshot(key.group_name(), group_id, snapshot))
+    return false;
+  on_scope_exit release_snapshot([snapshot, this]() {
+    storage_engine_->ReleaseSnapshot(snapshot);
+  });
+  leveldb::ReadOptions read_options;
+  read_options.snapshot = snapshot;
+  std::unique_ptr<leveldb::Iterator> iter(storage_engine_->NewIterator(read_options));
+  const LevelDbKey level_db_key(MakeLevelDbKey(group_id, key));
+  iter->Seek(level_db_key);
+  bool exists(false);
+  if (detail::MergeOperator<Value>::kEnabled) {
+    std::string value_string;
+    exists = detail::ReadMergedValue<Value>(*iter, level_db_key, value_string, nullptr);
+  } else {
+    exists = iter->Valid() && iter->key() == level_db_key;
+  }
+  if (!iter->status().ok())
+    BOOST_THROW_EXCEPTION(MakeError(VaultErrors::failed_to_handle_request));
+  return exists;
+}
+
+// The snapshot is taken while the group is known to be in the map, so its id can't yet have been
+// released and reused by another group.  Reads against it then run without any lock held.  The
+// caller must release the snapshot if this returns true.
+template <typename Persona>
+bool GroupDb<Persona>::FindGroupIdAndSnapshot(const GroupName& group_name, GroupId& group_id,
+                                              const leveldb::Snapshot*& snapshot) {
+  auto& shard(GetShard(group_name));
+  boost::shared_lock<boost::shared_mutex> map_lock(shard.map_mutex);
+  auto it(shard.group_map.find(group_name));
+  if (it == shard.group_map.end())
+    return false;
+  group_id = it->second.first;
+  snapshot = storage_engine_->GetSnapshot();
+  return true;
+}
+
+template <typename Persona>
+void GroupDb<Persona>::DeleteGroupEntries(Shard& shard, const GroupName& group_name) {
   try {
-    DeleteGroupEntries(FindGroup(group_name));
+    DeleteGroupEntries(shard, FindGroup(shard.group_map, group_name));
   } catch (const maidsafe_error& error) {
     LOG(kInfo) << "account doesn't exist for group "
                << HexSubstr(group_name->string()) << ", error : "
@@ -352,101 +815,145 @@ void GroupDb<Persona>::DeleteGroupEntries(const GroupName& group_name) {
 }
 
 template <typename Persona>
-void GroupDb<Persona>::DeleteGroupEntries(typename GroupMap::iterator it) {
-  assert(it != group_map_.end());
-  std::vector<std::string> group_db_keys;
-  const auto group_id = it->second.first;
-  const auto group_id_str = detail::ToFixedWidthString<kPrefixWidth_>(group_id);
-  std::unique_ptr<leveldb::Iterator> iter(leveldb_->NewIterator(leveldb::ReadOptions()));
-  for (iter->Seek(group_id_str);
+void GroupDb<Persona>::DeleteGroupEntries(Shard& shard, typename GroupMap::iterator it) {
+  assert(it != shard.group_map.end());
+  const GroupId group_id(it->second.first);
+  DeleteRange(group_id);
+  EraseGroup(shard, it);
+  ScheduleCompaction(group_id);
+}
+
+// The metadata entry sorts first so is removed in the first batch; if interrupted, the remaining
+// entries are cleaned up as orphans on recovery.
+template <typename Persona>
+void GroupDb<Persona>::DeleteRange(const GroupId& group_id) {
+  detail::DbBatchWriter batch_writer(*storage_engine_);
+  std::unique_ptr<leveldb::Iterator> iter(storage_engine_->NewIterator(leveldb::ReadOptions()));
+  for (iter->Seek(MakeGroupPrefix(group_id));
        (iter->Valid() && (GetGroupId(iter->key()) == group_id));
        iter->Next())
-    group_db_keys.push_back(iter->key().ToString());
-
+    batch_writer.Delete(iter->key());
+  if (!iter->status().ok())
+    BOOST_THROW_EXCEPTION(MakeError(VaultErrors::failed_to_handle_request));
   iter.reset();
+  batch_writer.Flush();
+}
 
-  for (const auto& key : group_db_keys) {
-    leveldb::Status status(leveldb_->Delete(leveldb::WriteOptions(), key));
-    if (!status.ok())
-      BOOST_THROW_EXCEPTION(MakeError(VaultErrors::failed_to_handle_request));
+template <typename Persona>
+void GroupDb<Persona>::ScheduleCompaction(const GroupId& group_id) {
+  std::lock_guard<std::mutex> lock(compaction_mutex_);
+  pending_compactions_.push_back(group_id);
+  if (compaction_scheduled_)
+    return;
+  compaction_scheduled_ = true;
+  compaction_service_.service().post([this] { CompactPendingRanges(); });
+}
+
+// Runs on 'compaction_service_', so no GroupDb mutex is held while leveldb compacts.
+template <typename Persona>
+void GroupDb<Persona>::CompactPendingRanges() {
+  std::vector<GroupId> group_ids;
+  {
+    std::lock_guard<std::mutex> lock(compaction_mutex_);
+    group_ids.swap(pending_compactions_);
+    compaction_scheduled_ = false;
+  }
+  for (const auto& group_id : group_ids) {
+    const GroupPrefix begin_prefix(MakeGroupPrefix(group_id));
+    const leveldb::Slice begin(begin_prefix);
+    if (static_cast<uint64_t>(group_id) + 1 == kGroupsLimit_) {
+      storage_engine_->CompactRange(&begin, nullptr);
+    } else {
+      const GroupPrefix end_prefix(MakeGroupPrefix(group_id + 1));
+      const leveldb::Slice end(end_prefix);
+      storage_engine_->CompactRange(&begin, &end);
+    }
   }
-  group_map_.erase(it);
-  leveldb_->CompactRange(nullptr, nullptr);
+  LOG(kVerbose) << "GroupDb<Persona>::CompactPendingRanges compacted " << group_ids.size()
+                << " deleted group ranges";
 }
 
-// throws
+// returns null if the key isn't in the db, throws on db errors.  The keys of any merge operands
+// folded into the returned value are appended to 'operand_keys' if it's non-null.
 template <typename Persona>
-typename GroupDb<Persona>::Value GroupDb<Persona>::Get(const Key& key, const GroupId& group_id) {
+std::unique_ptr<typename Persona::Value> GroupDb<Persona>::TryGet(
+    const Key& key, const GroupId& group_id, const leveldb::Snapshot* snapshot,
+    std::vector<std::string>* operand_keys) {
   leveldb::ReadOptions read_options;
-  read_options.verify_checksums = true;
+  read_options.verify_checksums = kVerifyChecksums_;
+  read_options.snapshot = snapshot;
   std::string value_string;
+  if (detail::MergeOperator<Value>::kEnabled) {
+    // The value's merge operands sort directly after it, so are read by the same seek.
+    const LevelDbKey level_db_key(MakeLevelDbKey(group_id, key));
+    std::unique_ptr<leveldb::Iterator> iter(storage_engine_->NewIterator(read_options));
+    iter->Seek(level_db_key);
+    if (!detail::ReadMergedValue<Value>(*iter, level_db_key, value_string, operand_keys))
+      return nullptr;
+    return std::unique_ptr<Value>(new Value(value_string));
+  }
   leveldb::Status status(
-              leveldb_->Get(read_options, MakeLevelDbKey(group_id, key), &value_string));
+              storage_engine_->Get(read_options, MakeLevelDbKey(group_id, key), &value_string));
   if (status.ok()) {
     assert(!value_string.empty());
-    return Value(value_string);
+    return std::unique_ptr<Value>(new Value(value_string));
   } else if (status.IsNotFound()) {
-    LOG(kWarning) << "cann't find such element for get, throwing error";
-    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::no_such_element));
+    return nullptr;
   }
   LOG(kError) << "unknown error";
   BOOST_THROW_EXCEPTION(MakeError(VaultErrors::failed_to_handle_request));
 }
 
 template <typename Persona>
-void GroupDb<Persona>::Put(const KvPair& key_value_pair, const GroupId& group_id) {
-  leveldb::Status status(leveldb_->Put(leveldb::WriteOptions(),
-                                       MakeLevelDbKey(group_id, key_value_pair.first),
-                                       key_value_pair.second.Serialise()));
-  if (!status.ok())
-    BOOST_THROW_EXCEPTION(MakeError(VaultErrors::failed_to_handle_request));
-}
-
-template <typename Persona>
-void GroupDb<Persona>::Delete(const Key& key, const GroupId& group_id) {
-  leveldb::Status status(
-      leveldb_->Delete(leveldb::WriteOptions(), MakeLevelDbKey(group_id, key)));
-  if (!status.ok())
-    BOOST_THROW_EXCEPTION(MakeError(VaultErrors::failed_to_handle_request));
+typename GroupDb<Persona>::LevelDbKey GroupDb<Persona>::MakeLevelDbKey(const GroupId& group_id,
+                                                                       const Key& key) {
+  LevelDbKey level_db_key;
+  detail::EncodeFixedWidth<kPrefixWidth_>(group_id, level_db_key.data());
+  key.ToFixedWidth(level_db_key.data() + kPrefixWidth_);
+  return level_db_key;
 }
 
 template <typename Persona>
-std::string GroupDb<Persona>::MakeLevelDbKey(const GroupId& group_id, const Key& key) {
-  return detail::ToFixedWidthString<kPrefixWidth_>(group_id) + key.ToFixedWidthString().string();
+typename GroupDb<Persona>::GroupPrefix GroupDb<Persona>::MakeGroupPrefix(
+    const GroupId& group_id) {
+  GroupPrefix prefix;
+  detail::EncodeFixedWidth<kPrefixWidth_>(group_id, prefix.data());
+  return prefix;
 }
 
 template <typename Persona>
 typename Persona::Key GroupDb<Persona>::MakeKey(const GroupName group_name,
                                                 const leveldb::Slice& level_db_key) {
-  return Key(group_name, typename Persona::Key::FixedWidthString(
-                 (level_db_key.ToString()).substr(kPrefixWidth_)));
+  assert(level_db_key.size() >= kLevelDbKeySize_);
+  return Key::FromFixedWidth(group_name, level_db_key.data() + kPrefixWidth_);
 }
 
 template <typename Persona>
-uint32_t GroupDb<Persona>::GetGroupId(const leveldb::Slice& level_db_key) const {
-  return detail::FromFixedWidthString<kPrefixWidth_>(
-      (level_db_key.ToString()).substr(0, kPrefixWidth_));
+typename GroupDb<Persona>::GroupId GroupDb<Persona>::GetGroupId(
+    const leveldb::Slice& level_db_key) {
+  assert(level_db_key.size() >= static_cast<size_t>(kPrefixWidth_));
+  return detail::DecodeFixedWidth<kPrefixWidth_>(level_db_key.data());
 }
 
 // throws
 template <typename Persona>
 typename GroupDb<Persona>::GroupMap::iterator GroupDb<Persona>::FindGroup(
-    const GroupName& group_name) {
-  auto it(group_map_.find(group_name));
-  if (it == group_map_.end())
+    GroupMap& group_map, const GroupName& group_name) {
+  auto it(group_map.find(group_name));
+  if (it == group_map.end())
     BOOST_THROW_EXCEPTION(MakeError(VaultErrors::no_such_account));
   return it;
 }
 
 template <typename Persona>
 typename GroupDb<Persona>::GroupMap::iterator GroupDb<Persona>::FindOrCreateGroup(
-    const GroupName& group_name) {
+    Shard& shard, const GroupName& group_name) {
   LOG(kInfo) << "GroupDb<Persona>::FindOrCreateGroup generic -- Don't Do Creation --";
-  return FindGroup(group_name);
+  return FindGroup(shard.group_map, group_name);
 }
 
 template <typename Persona>
-void GroupDb<Persona>::UpdateGroup(typename GroupMap::iterator itr) {
+void GroupDb<Persona>::UpdateGroup(Shard& /*shard*/, typename GroupMap::iterator itr) {
   LOG(kInfo) << "GroupDb<Persona>::UpdateGroup updating " << HexSubstr(itr->first->string())
              << ". -- Do Nothing --";
 }  // Do Nothing
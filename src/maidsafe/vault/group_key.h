@@ -19,6 +19,7 @@
 #ifndef MAIDSAFE_VAULT_GROUP_KEY_H_
 #define MAIDSAFE_VAULT_GROUP_KEY_H_
 
+#include <cstring>
 #include <string>
 #include <tuple>
 
@@ -59,12 +60,14 @@ struct GroupKey {
   friend class GroupDb;
 
  private:
-  typedef maidsafe::detail::BoundedString<NodeId::kSize + detail::PaddedWidth::value,
-                                          NodeId::kSize + detail::PaddedWidth::value>
-      FixedWidthString;
-
-  GroupKey(const GroupName& group_name_in, const FixedWidthString& fixed_width_string);
-  FixedWidthString ToFixedWidthString() const;
+  // Width of the key, less its group name, as stored in a GroupDb: the name followed by the padded
+  // type.
+  static const size_t kFixedWidthSize = NodeId::kSize + detail::PaddedWidth::value;
+
+  // Reads the kFixedWidthSize bytes at 'fixed_width'.
+  static GroupKey FromFixedWidth(const GroupName& group_name_in, const char* fixed_width);
+  // Writes kFixedWidthSize bytes to 'fixed_width'.
+  void ToFixedWidth(char* fixed_width) const;
 };
 
 template <typename GroupName>
@@ -87,14 +90,6 @@ GroupKey<GroupName>::GroupKey(const std::string& serialised_group_key)
   type = static_cast<DataTagValue>(group_key_proto.type());
 }
 
-template <typename GroupName>
-GroupKey<GroupName>::GroupKey(const GroupName& group_name_in,
-                              const FixedWidthString& fixed_width_string)
-    : metadata_key(group_name_in),
-      name(fixed_width_string.string().substr(0, NodeId::kSize)),
-      type(static_cast<DataTagValue>(detail::FromFixedWidthString<detail::PaddedWidth::value>(
-          fixed_width_string.string().substr(NodeId::kSize)))) {}
-
 template <typename GroupName>
 GroupKey<GroupName>::GroupKey(const GroupKey& other)
     : metadata_key(other.metadata_key), name(other.name), type(other.type) {}
@@ -121,9 +116,19 @@ std::string GroupKey<GroupName>::Serialise() const {
 }
 
 template <typename GroupName>
-typename GroupKey<GroupName>::FixedWidthString GroupKey<GroupName>::ToFixedWidthString() const {
-  return FixedWidthString(name.string() + detail::ToFixedWidthString<detail::PaddedWidth::value>(
-                                              static_cast<uint32_t>(type)));
+GroupKey<GroupName> GroupKey<GroupName>::FromFixedWidth(const GroupName& group_name_in,
+                                                        const char* fixed_width) {
+  return GroupKey(group_name_in, Identity(std::string(fixed_width, NodeId::kSize)),
+                  static_cast<DataTagValue>(detail::DecodeFixedWidth<detail::PaddedWidth::value>(
+                      fixed_width + NodeId::kSize)));
+}
+
+template <typename GroupName>
+void GroupKey<GroupName>::ToFixedWidth(char* fixed_width) const {
+  assert(name.string().size() == NodeId::kSize);
+  std::memcpy(fixed_width, name.string().data(), NodeId::kSize);
+  detail::EncodeFixedWidth<detail::PaddedWidth::value>(static_cast<uint32_t>(type),
+                                                       fixed_width + NodeId::kSize);
 }
 
 template <typename GroupName>
@@ -18,6 +18,7 @@
 
 #include "maidsafe/vault/key.h"
 
+#include <cstring>
 #include <tuple>
 
 #include "maidsafe/common/error.h"
@@ -40,11 +41,6 @@ Key::Key(const std::string& serialised_key) : name(), type(DataTagValue::kMutabl
   type = static_cast<DataTagValue>(key_proto.type());
 }
 
-Key::Key(const FixedWidthString& fixed_width_string)
-    : name(fixed_width_string.string().substr(0, NodeId::kSize)),
-      type(static_cast<DataTagValue>(detail::FromFixedWidthString<detail::PaddedWidth::value>(
-          fixed_width_string.string().substr(NodeId::kSize)))) {}
-
 Key::Key(const Key& other) : name(other.name), type(other.type) {}
 
 Key::Key(Key&& other) : name(std::move(other.name)), type(std::move(other.type)) {}
@@ -61,9 +57,17 @@ std::string Key::Serialise() const {
   return key_proto.SerializeAsString();
 }
 
-Key::FixedWidthString Key::ToFixedWidthString() const {
-  return FixedWidthString(name.string() + detail::ToFixedWidthString<detail::PaddedWidth::value>(
-                                              static_cast<uint32_t>(type)));
+Key Key::FromFixedWidth(const char* fixed_width) {
+  return Key(Identity(std::string(fixed_width, NodeId::kSize)),
+             static_cast<DataTagValue>(detail::DecodeFixedWidth<detail::PaddedWidth::value>(
+                 fixed_width + NodeId::kSize)));
+}
+
+void Key::ToFixedWidth(char* fixed_width) const {
+  assert(name.string().size() == NodeId::kSize);
+  std::memcpy(fixed_width, name.string().data(), NodeId::kSize);
+  detail::EncodeFixedWidth<detail::PaddedWidth::value>(static_cast<uint32_t>(type),
+                                                       fixed_width + NodeId::kSize);
 }
 
 void swap(Key& lhs, Key& rhs) MAIDSAFE_NOEXCEPT {
@@ -61,12 +61,13 @@ struct Key {
   friend class Db;
 
  private:
-  typedef maidsafe::detail::BoundedString<NodeId::kSize + detail::PaddedWidth::value,
-                                          NodeId::kSize + detail::PaddedWidth::value>
-      FixedWidthString;
+  // Width of the key as stored in a Db: the name followed by the padded type.
+  static const size_t kFixedWidthSize = NodeId::kSize + detail::PaddedWidth::value;
 
-  explicit Key(const FixedWidthString& fixed_width_string);
-  FixedWidthString ToFixedWidthString() const;
+  // Reads the kFixedWidthSize bytes at 'fixed_width'.
+  static Key FromFixedWidth(const char* fixed_width);
+  // Writes kFixedWidthSize bytes to 'fixed_width'.
+  void ToFixedWidth(char* fixed_width) const;
 };
 
 void swap(Key& lhs, Key& rhs) MAIDSAFE_NOEXCEPT;
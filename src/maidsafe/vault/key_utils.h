@@ -35,29 +35,49 @@ struct PaddedWidth {
   static const int value = 1;
 };
 
+// Width of the group id prefix on GroupDb keys.  This allows for 2 ^ (8 * value) groups per db.
+struct GroupDbPrefixWidth {
+  static const int value = 3;
+};
+
+// Merge operands are stored under their value's key followed by a big-endian sequence number of
+// this width, so each value's operands sort directly after it.
+struct MergeSequenceWidth {
+  static const int value = 8;
+};
+
+// Writes 'number' big-endian to the 'width' bytes at 'out'.
 template <int width>
-std::string ToFixedWidthString(uint32_t number) {
+void EncodeFixedWidth(uint32_t number, char* out) {
   static_assert(width > 0 && width < 5, "width must be 1, 2, 3, or 4.");
   assert(number < std::pow(256, width));
-  std::string result(width, 0);
   for (int i(0); i != width; ++i) {
-    result[width - i - 1] = static_cast<char>(number);
+    out[width - i - 1] = static_cast<char>(number);
     number /= 256;
   }
+}
+
+// Reads a number written by EncodeFixedWidth from the 'width' bytes at 'in'.
+template <int width>
+uint32_t DecodeFixedWidth(const char* in) {
+  static_assert(width > 0 && width < 5, "width must be 1, 2, 3, or 4.");
+  uint32_t result(0);
+  for (int i(0); i != width; ++i)
+    result = (result << 8) | static_cast<unsigned char>(in[i]);
+  return result;
+}
+
+template <int width>
+std::string ToFixedWidthString(uint32_t number) {
+  std::string result(width, 0);
+  EncodeFixedWidth<width>(number, &result[0]);
   return result;
 }
 
 template <int width>
 uint32_t FromFixedWidthString(const std::string& number_as_string) {
-  static_assert(width > 0 && width < 5, "width must be 1, 2, 3, or 4.");
   assert(static_cast<int>(number_as_string.size()) == width);
-  uint32_t result(0), factor(1);
-  for (int i(0); i != width; ++i) {
-    result += (static_cast<unsigned char>(number_as_string[width - i - 1]) * factor);
-    factor *= 256;
-  }
-  assert(result < std::pow(256, width));
-  return result;
+  return DecodeFixedWidth<width>(number_as_string.data());
 }
 
 template <>
@@ -21,6 +21,7 @@
 #include <utility>
 
 #include "maidsafe/vault/maid_manager/maid_manager.pb.h"
+#include "maidsafe/vault/maid_manager/value.h"
 #include "maidsafe/vault/pmid_manager/metadata.h"
 
 namespace maidsafe {
@@ -109,6 +110,17 @@ void MaidManagerMetadata::UnregisterPmid(const PmidName& pmid_name) {
     pmid_totals_.erase(itr);
 }
 
+void MaidManagerMetadata::Merge(const MaidManagerMetadata& other) {
+  for (const auto& pmid_totals : other.pmid_totals_) {
+    if (Find(pmid_totals.pmid_metadata.pmid_name) == std::end(pmid_totals_))
+      pmid_totals_.push_back(pmid_totals);
+  }
+}
+
+void MaidManagerMetadata::AddTransferredValue(const MaidManagerValue& value) {
+  total_put_data_ += value.total_cost();
+}
+
 void MaidManagerMetadata::UpdatePmidTotals(const PmidManagerMetadata& pmid_metadata) {
   auto itr(Find(pmid_metadata.pmid_name));
   if (itr == std::end(pmid_totals_)) {
@@ -35,6 +35,7 @@ class MaidManagerServiceTest;
 }
 
 struct PmidManagerMetadata;
+class MaidManagerValue;
 
 class MaidManagerMetadata {
  public:
@@ -58,6 +59,11 @@ class MaidManagerMetadata {
   void RegisterPmid(const nfs_vault::PmidRegistration& pmid_registration);
   void UnregisterPmid(const PmidName& pmid_name);
   void UpdatePmidTotals(const PmidManagerMetadata& pmid_metadata);
+  // Adds the pmids of a copy of this account held elsewhere, e.g. one transferred to this node, which
+  // aren't registered here.  The put total is credited per entry by AddTransferredValue.
+  void Merge(const MaidManagerMetadata& other);
+  // Credits the put total with a transferred entry which this account didn't hold.
+  void AddTransferredValue(const MaidManagerValue& value);
 
   friend void swap(MaidManagerMetadata& lhs, MaidManagerMetadata& rhs);
   friend bool operator==(const MaidManagerMetadata& lhs, const MaidManagerMetadata& rhs);
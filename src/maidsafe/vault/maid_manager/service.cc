@@ -38,7 +38,6 @@
 #include "maidsafe/vault/maid_manager/metadata.h"
 #include "maidsafe/vault/sync.h"
 #include "maidsafe/vault/sync.pb.h"
-#include "maidsafe/vault/maid_manager/action_reference_count.h"
 
 namespace maidsafe {
 
@@ -150,13 +149,15 @@ T Merge(std::vector<T> values) {
 }  // unnamed namespace
 
 MaidManagerService::MaidManagerService(const passport::Pmid& pmid, routing::Routing& routing,
-                                       nfs_client::DataGetter& data_getter)
+                                       nfs_client::DataGetter& data_getter,
+                                       const boost::filesystem::path& vault_root_dir)
     : routing_(routing),
       data_getter_(data_getter),
-      group_db_(),
+      group_db_(detail::PersonaDbPath(vault_root_dir, "maid_manager"),
+                detail::Parameters::maid_manager_db_options),
       accumulator_mutex_(),
-      nfs_accumulator_(),
-      vault_accumulator_(),
+      nfs_accumulator_(detail::Parameters::maid_manager_accumulator_options),
+      vault_accumulator_(detail::Parameters::maid_manager_accumulator_options),
       dispatcher_(routing_, pmid),
       sync_create_accounts_(NodeId(pmid.name()->string())),
       sync_remove_accounts_(NodeId(pmid.name()->string())),
@@ -168,7 +169,28 @@ MaidManagerService::MaidManagerService(const passport::Pmid& pmid, routing::Rout
       sync_increment_reference_counts_(NodeId(pmid.name()->string())),
       sync_decrement_reference_counts_(NodeId(pmid.name()->string())),
       pending_account_mutex_(),
-      pending_account_map_() {}
+      pending_account_map_(),
+      asio_service_(1),
+      sync_retransmitters_() {
+  sync_retransmitters_.push_back(
+      detail::MakeSyncRetransmitter(asio_service_, dispatcher_, sync_create_accounts_));
+  sync_retransmitters_.push_back(
+      detail::MakeSyncRetransmitter(asio_service_, dispatcher_, sync_remove_accounts_));
+  sync_retransmitters_.push_back(
+      detail::MakeSyncRetransmitter(asio_service_, dispatcher_, sync_puts_));
+  sync_retransmitters_.push_back(
+      detail::MakeSyncRetransmitter(asio_service_, dispatcher_, sync_deletes_));
+  sync_retransmitters_.push_back(
+      detail::MakeSyncRetransmitter(asio_service_, dispatcher_, sync_register_pmids_));
+  sync_retransmitters_.push_back(
+      detail::MakeSyncRetransmitter(asio_service_, dispatcher_, sync_unregister_pmids_));
+  sync_retransmitters_.push_back(
+      detail::MakeSyncRetransmitter(asio_service_, dispatcher_, sync_update_pmid_healths_));
+  sync_retransmitters_.push_back(
+      detail::MakeSyncRetransmitter(asio_service_, dispatcher_, sync_increment_reference_counts_));
+  sync_retransmitters_.push_back(
+      detail::MakeSyncRetransmitter(asio_service_, dispatcher_, sync_decrement_reference_counts_));
+}
 
 // =============== Maid Account Creation ===========================================================
 
@@ -468,7 +490,11 @@ void MaidManagerService::HandleSyncedPutResponse(
   // BEFORE_RELEASE difference process for account_transfer (avoiding double hash)
   ObfuscateKey(synced_action_put->key);
   try {
-    group_db_.Commit(synced_action_put->key, synced_action_put->action);
+    // The put only adds to the value, so is merged rather than read, modified and written back.
+    const int32_t cost(synced_action_put->action.kCost);
+    group_db_.Merge(synced_action_put->key,
+                    detail::MergeOperator<MaidManagerValue>::MakeOperand(1, cost),
+                    [cost](MaidManagerMetadata& metadata) { metadata.PutData(cost); });
   }
   catch (const maidsafe_error& error) {
     LOG(kWarning) << "MaidManagerService::HandleSyncedPutResponse failed";
@@ -858,12 +884,25 @@ void MaidManagerService::HandleMessage(
     const typename SynchroniseFromMaidManagerToMaidManager::Sender& sender,
     const typename SynchroniseFromMaidManagerToMaidManager::Receiver& /*receiver*/) {
   LOG(kVerbose) << message;
-  protobuf::Sync proto_sync;
-  if (!proto_sync.ParseFromString(message.contents->data)) {
+  protobuf::SyncBatch proto_sync_batch;
+  if (!proto_sync_batch.ParseFromString(message.contents->data)) {
     LOG(kError) << "SynchroniseFromMaidManagerToMaidManager can't parse the content";
     return;
 //     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
   }
+  for (const auto& proto_sync : proto_sync_batch.syncs()) {
+    try {
+      HandleSync(proto_sync, sender);
+    }
+    catch (const maidsafe_error& error) {
+      LOG(kError) << "SynchroniseFromMaidManagerToMaidManager failed to handle action type "
+                  << proto_sync.action_type() << ": " << boost::diagnostic_information(error);
+    }
+  }
+}
+
+void MaidManagerService::HandleSync(const protobuf::Sync& proto_sync,
+                                    const routing::GroupSource& sender) {
   switch (static_cast<nfs::MessageAction>(proto_sync.action_type())) {
     case ActionMaidManagerPut::kActionId: {
       LOG(kVerbose) << "SynchroniseFromMaidManagerToMaidManager ActionMaidManagerPut";
@@ -1007,16 +1046,10 @@ void MaidManagerService::HandleDecrementReferenceCounts(const MaidName& maid_nam
 
 bool MaidManagerService::CheckDataNamesExist(const MaidName& maid_name,
                                              const nfs_vault::DataNames& data_names) {
-  try {
-    for (const auto& data_name : data_names.data_names_) {
-      MaidManager::Key key(MaidManager::GroupName(maid_name), data_name.raw_name, data_name.type);
-      group_db_.GetValue(key);
-    }
-  }
-  catch (const maidsafe_error& error) {
-    if (error.code() != make_error_code(VaultErrors::no_such_account))
-      throw;
-     return false;
+  for (const auto& data_name : data_names.data_names_) {
+    MaidManager::Key key(MaidManager::GroupName(maid_name), data_name.raw_name, data_name.type);
+    if (!group_db_.Exists(key))
+      return false;
   }
   return true;
 }
@@ -1029,7 +1062,7 @@ void MaidManagerService::HandleSyncedIncrementReferenceCounts(
            synced_action_increment_reference_counts->action.kDataNames.data_names_) {
     MaidManager::Key key(MaidManager::GroupName(metadata_key.group_name()), data_name.raw_name,
                          ImmutableData::Tag::kValue);
-    group_db_.Commit(key, ActionMaidManagerIncrementReferenceCount());
+    group_db_.Merge(key, detail::MergeOperator<MaidManagerValue>::MakeOperand(1, 0));
   }
 }
 
@@ -1041,7 +1074,7 @@ void MaidManagerService::HandleSyncedDecrementReferenceCounts(
            synced_action_decrement_reference_counts->action.kDataNames.data_names_) {
     MaidManager::Key key(MaidManager::GroupName(metadata_key.group_name()), data_name.raw_name,
                          ImmutableData::Tag::kValue);
-    group_db_.Commit(key, ActionMaidManagerDecrementReferenceCount());
+    group_db_.Merge(key, detail::MergeOperator<MaidManagerValue>::MakeOperand(-1, 0));
   }
 }
 
@@ -27,10 +27,12 @@
 #include <type_traits>
 #include <vector>
 
+#include "boost/filesystem/path.hpp"
 #include "boost/mpl/vector.hpp"
 #include "boost/mpl/insert_range.hpp"
 #include "boost/mpl/end.hpp"
 
+#include "maidsafe/common/asio_service.h"
 #include "maidsafe/common/error.h"
 #include "maidsafe/common/log.h"
 #include "maidsafe/common/on_scope_exit.h"
@@ -63,6 +65,7 @@
 #include "maidsafe/vault/maid_manager/maid_manager.pb.h"
 #include "maidsafe/vault/operation_visitors.h"
 #include "maidsafe/vault/sync.h"
+#include "maidsafe/vault/sync.pb.h"
 
 namespace maidsafe {
 
@@ -88,8 +91,10 @@ class MaidManagerService {
   typedef MaidManagerServiceMessages VaultMessages;
   typedef void HandleMessageReturnType;
 
+  // If 'vault_root_dir' is empty, the account db is not persisted.
   MaidManagerService(const passport::Pmid& pmid, routing::Routing& routing,
-                     nfs_client::DataGetter& data_getter);
+                     nfs_client::DataGetter& data_getter,
+                     const boost::filesystem::path& vault_root_dir = boost::filesystem::path());
 
   template <typename MessageType>
   void HandleMessage(const MessageType& message, const typename MessageType::Sender& sender,
@@ -106,6 +111,9 @@ class MaidManagerService {
   MaidManagerService(MaidManagerService&&);
   MaidManagerService& operator=(MaidManagerService&&);
 
+  // Applies one action from a received batch of syncs.
+  void HandleSync(const protobuf::Sync& proto_sync, const routing::GroupSource& sender);
+
   //  void CheckSenderIsConnectedMaidNode(const nfs::Message& message) const;
   //  void CheckSenderIsConnectedMaidManager(const nfs::Message& message) const;
   //  void ValidateDataSender(const nfs::Message& message) const;
@@ -302,6 +310,8 @@ class MaidManagerService {
   static const int kDefaultPaymentFactor_;
   std::mutex pending_account_mutex_;
   std::map<nfs::MessageId, MaidAccountCreationStatus> pending_account_map_;
+  AsioService asio_service_;
+  std::vector<std::unique_ptr<detail::SyncRetransmitter>> sync_retransmitters_;
 };
 
 template <typename MessageType>
@@ -608,17 +618,7 @@ void MaidManagerService::ValidatePmidRegistration(
 
 template <typename UnresolvedAction>
 void MaidManagerService::DoSync(const UnresolvedAction& unresolved_action) {
-  detail::IncrementAttemptsAndSendSync(dispatcher_, sync_puts_, unresolved_action);
-  detail::IncrementAttemptsAndSendSync(dispatcher_, sync_deletes_, unresolved_action);
-  detail::IncrementAttemptsAndSendSync(dispatcher_, sync_create_accounts_, unresolved_action);
-  detail::IncrementAttemptsAndSendSync(dispatcher_, sync_remove_accounts_, unresolved_action);
-  detail::IncrementAttemptsAndSendSync(dispatcher_, sync_register_pmids_, unresolved_action);
-  detail::IncrementAttemptsAndSendSync(dispatcher_, sync_unregister_pmids_, unresolved_action);
-  detail::IncrementAttemptsAndSendSync(dispatcher_, sync_update_pmid_healths_, unresolved_action);
-  detail::IncrementAttemptsAndSendSync(dispatcher_, sync_increment_reference_counts_,
-                                       unresolved_action);
-  detail::IncrementAttemptsAndSendSync(dispatcher_, sync_decrement_reference_counts_,
-                                       unresolved_action);
+  detail::SendSyncAction(dispatcher_, unresolved_action);
 }
 
 }  // namespace vault
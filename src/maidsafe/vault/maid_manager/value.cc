@@ -105,6 +105,37 @@ bool operator==(const MaidManagerValue& lhs, const MaidManagerValue& rhs) {
   return lhs.count() == rhs.count() && lhs.total_cost() == rhs.total_cost();
 }
 
+namespace detail {
+
+std::string MergeOperator<MaidManagerValue>::MakeOperand(int32_t count, int64_t total_cost) {
+  protobuf::MaidManagerValueDelta delta_proto;
+  delta_proto.set_count(count);
+  delta_proto.set_total_cost(total_cost);
+  return delta_proto.SerializeAsString();
+}
+
+DbAction MergeOperator<MaidManagerValue>::Apply(const std::string& operand,
+                                                std::unique_ptr<MaidManagerValue>& value) {
+  protobuf::MaidManagerValueDelta delta_proto;
+  if (!delta_proto.ParseFromString(operand)) {
+    LOG(kError) << "Failed to parse maid manager value merge operand.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+  }
+  if (!value) {
+    if (delta_proto.count() <= 0) {
+      LOG(kWarning) << "MaidManagerValue merge operand decrements a missing value; ignored";
+      return DbAction::kDelete;
+    }
+    value.reset(new MaidManagerValue());
+  }
+  value->count_ += delta_proto.count();
+  value->total_cost_ += delta_proto.total_cost();
+  GLOG() << "MaidManager merged count to " << value->count_;
+  return (value->count_ <= 0 || value->total_cost_ <= 0) ? DbAction::kDelete : DbAction::kPut;
+}
+
+}  // namespace detail
+
 }  // namespace vault
 
 }  // namespace maidsafe
@@ -20,12 +20,31 @@
 #define MAIDSAFE_VAULT_MAID_MANAGER_VALUE_H_
 
 #include <cstdint>
+#include <memory>
 #include <string>
 
+#include "maidsafe/vault/config.h"
+
 namespace maidsafe {
 
 namespace vault {
 
+class MaidManagerValue;
+
+namespace detail {
+
+// Allows reference counts and costs to be adjusted by GroupDb::Merge without reading the value.
+template <>
+struct MergeOperator<MaidManagerValue> {
+  static const bool kEnabled = true;
+  static std::string MakeOperand(int32_t count, int64_t total_cost);
+  // An operand for a missing value creates it.  The value is deleted once its count or total cost
+  // drops to zero.
+  static DbAction Apply(const std::string& operand, std::unique_ptr<MaidManagerValue>& value);
+};
+
+}  // namespace detail
+
 class MaidManagerValue {
  public:
   explicit MaidManagerValue(const std::string& serialised_maid_manager_value);
@@ -43,6 +62,7 @@ class MaidManagerValue {
   int64_t total_cost() const { return total_cost_; }
 
   friend void swap(MaidManagerValue& lhs, MaidManagerValue& rhs);
+  friend struct detail::MergeOperator<MaidManagerValue>;
 #ifdef MAIDSAFE_APPLE  // BEFORE_RELEASE This copy constructor definition is to allow building
                        // on mac with clang 3.3, should be removed if clang is updated on mac.
   MaidManagerValue(const MaidManagerValue& other)
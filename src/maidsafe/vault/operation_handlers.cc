@@ -648,7 +648,7 @@ void OperationHandler<
     return;
   {
     std::lock_guard<std::mutex> lock(mutex);
-    if (accumulator.CheckHandled(message))
+    if (accumulator.CheckHandled(message, sender))
       return;
     auto result(accumulator.AddPendingRequest(message, sender, checker));
     if (result == Accumulator<PmidNodeServiceMessages>::AddResult::kSuccess) {
@@ -662,6 +662,7 @@ void OperationHandler<
         else
          failures++;
       }
+      accumulator.SetHandled(message, sender);
       service->HandlePmidAccountResponses(response_vec, failures);
     } else if (result == Accumulator<PmidNodeServiceMessages>::AddResult::kFailure) {
       service->StartUp();
@@ -94,6 +94,7 @@ void OperationHandler<ValidateSender, AccumulatorType, Checker, ServiceHandlerTy
       LOG(kInfo) << "AddPendingRequest unsuccessful";
       return;
     }
+    accumulator.SetHandled(message, sender);
   }
   DoOperation<ServiceHandlerType, MessageType>(service, message, sender, receiver);
 }
@@ -29,11 +29,43 @@ namespace vault {
 
 namespace detail {
 
+DbOptions::DbOptions()
+    : storage_engine(StorageEngineType::kLevelDb),
+      block_cache_size(8 << 20),
+      write_buffer_size(4 << 20),
+      bloom_filter_bits_per_key(10),
+      compression(true),
+      verify_checksums(true) {}
+
+AccumulatorOptions::AccumulatorOptions()
+    : pending_request_lifetime(std::chrono::seconds(60)),
+      max_pending_requests_count(1000),
+      max_pending_requests_size(64 << 20),
+      max_handled_requests_count(1000) {}
+
 const int Parameters::kMinNetworkHealth(12);
 size_t Parameters::max_recent_data_list_size(1000);
 int Parameters::max_file_element_count(10000);
 int Parameters::integrity_check_string_size(64);
 const std::chrono::milliseconds Parameters::kDefaultTimeout(10000);
+size_t Parameters::max_db_write_batch_count(1000);
+size_t Parameters::max_transfer_batch_count(1000);
+size_t Parameters::data_manager_db_cache_capacity(10000);
+DbOptions Parameters::data_manager_db_options;
+DbOptions Parameters::version_handler_db_options;
+DbOptions Parameters::maid_manager_db_options;
+DbOptions Parameters::pmid_manager_db_options;
+size_t Parameters::db_existence_filter_bits(1 << 23);
+size_t Parameters::max_pending_merge_operands(64);
+std::chrono::milliseconds Parameters::sync_retransmission_interval(2000);
+std::chrono::milliseconds Parameters::max_sync_retransmission_interval(32000);
+size_t Parameters::max_sync_batch_count(100);
+bool Parameters::delta_sync(true);
+AccumulatorOptions Parameters::data_manager_accumulator_options;
+AccumulatorOptions Parameters::version_handler_accumulator_options;
+AccumulatorOptions Parameters::maid_manager_accumulator_options;
+AccumulatorOptions Parameters::pmid_manager_accumulator_options;
+AccumulatorOptions Parameters::pmid_node_accumulator_options;
 
 }  // namespace detail
 
@@ -28,6 +28,39 @@ namespace vault {
 
 namespace detail {
 
+enum class StorageEngineType { kLevelDb, kInMemory };
+
+// Storage engine choice and LevelDB tuning for a single persona's store.  The tuning options are
+// ignored by the in-memory engine.
+struct DbOptions {
+  DbOptions();
+  StorageEngineType storage_engine;
+  // Size in bytes of the LRU block cache.  Stores configured with the same size share a cache.
+  size_t block_cache_size;
+  // Size in bytes of the in-memory write buffer
+  size_t write_buffer_size;
+  // Bits per key of the bloom filter policy (0 disables the filter)
+  int bloom_filter_bits_per_key;
+  // Whether blocks are snappy-compressed
+  bool compression;
+  // Whether reads verify block checksums
+  bool verify_checksums;
+};
+
+// Limits on the group requests each persona's accumulator holds while waiting for a quorum.
+struct AccumulatorOptions {
+  AccumulatorOptions();
+  // Time a message's requests are held for before being dropped
+  std::chrono::steady_clock::duration pending_request_lifetime;
+  // Max number of messages with pending requests
+  size_t max_pending_requests_count;
+  // Max total size in bytes of the pending requests, as estimated from their contents' data
+  size_t max_pending_requests_size;
+  // Max number of handled messages remembered, so that late requests for them are dropped.  If 0,
+  // none are remembered.
+  size_t max_handled_requests_count;
+};
+
 struct Parameters {
  public:
   // Min % returned by routing.network_status() to consider this node still online.
@@ -40,6 +73,38 @@ struct Parameters {
   static int integrity_check_string_size;
   // Default network timeout
   static const std::chrono::milliseconds kDefaultTimeout;
+  // Max number of puts/deletes committed to a db in a single write batch
+  static size_t max_db_write_batch_count;
+  // Max number of entries buffered for transfer to new holders during churn before being handed on
+  static size_t max_transfer_batch_count;
+  // Max number of decoded values cached in front of the DataManager db (0 disables the cache)
+  static size_t data_manager_db_cache_capacity;
+  // Storage options of each persona's db
+  static DbOptions data_manager_db_options;
+  static DbOptions version_handler_db_options;
+  static DbOptions maid_manager_db_options;
+  static DbOptions pmid_manager_db_options;
+  // Size in bits of each Db's in-memory existence filter.  It stays effective for up to about an
+  // eighth as many keys (a million keys at the default).
+  static size_t db_existence_filter_bits;
+  // Max number of merge operands left pending on a value before the next merge folds them into it
+  static size_t max_pending_merge_operands;
+  // Initial and max intervals between resends of a Sync's unresolved actions.  The interval doubles
+  // after each resend while actions remain unresolved.
+  static std::chrono::milliseconds sync_retransmission_interval;
+  static std::chrono::milliseconds max_sync_retransmission_interval;
+  // Max number of actions sent together in a single sync message
+  static size_t max_sync_batch_count;
+  // If true, a Sync also stops resending this node's entry for an action once it and the peers
+  // which acknowledged the entry, by listing this node in their syncs' seen lists, make a majority
+  // of the group, rather than only once every member's entry has been received
+  static bool delta_sync;
+  // Accumulator limits of each persona
+  static AccumulatorOptions data_manager_accumulator_options;
+  static AccumulatorOptions version_handler_accumulator_options;
+  static AccumulatorOptions maid_manager_accumulator_options;
+  static AccumulatorOptions pmid_manager_accumulator_options;
+  static AccumulatorOptions pmid_node_accumulator_options;
 
  private:
   Parameters();
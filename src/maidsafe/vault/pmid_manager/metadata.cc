@@ -18,10 +18,13 @@
 
 #include "maidsafe/vault/pmid_manager/metadata.h"
 
+#include <algorithm>
+
 #include "maidsafe/common/log.h"
 #include "maidsafe/common/utils.h"
 
 #include "maidsafe/vault/pmid_manager/pmid_manager.pb.h"
+#include "maidsafe/vault/pmid_manager/value.h"
 
 namespace maidsafe {
 namespace vault {
@@ -113,6 +116,20 @@ void PmidManagerMetadata::SetAvailableSize(const int64_t& available_size) {
   claimed_available_size = available_size;
 }
 
+void PmidManagerMetadata::Merge(const PmidManagerMetadata& other) {
+  if (!pmid_name->IsInitialised())
+    pmid_name = other.pmid_name;
+  // Both copies recorded the same account's losses, so the larger record is kept, not the sum.
+  lost_count = std::max(lost_count, other.lost_count);
+  lost_total_size = std::max(lost_total_size, other.lost_total_size);
+  if (claimed_available_size == 0)
+    claimed_available_size = other.claimed_available_size;
+}
+
+void PmidManagerMetadata::AddTransferredValue(const PmidManagerValue& value) {
+  PutData(value.size());
+}
+
 
 // BEFORE_RELEASE check if group can be deleted with below check
 detail::GroupDbMetaDataStatus PmidManagerMetadata::GroupStatus() {
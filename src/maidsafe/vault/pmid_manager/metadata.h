@@ -32,6 +32,8 @@ namespace maidsafe {
 
 namespace vault {
 
+class PmidManagerValue;
+
 struct PmidManagerMetadata {
  public:
   PmidManagerMetadata();
@@ -45,6 +47,12 @@ struct PmidManagerMetadata {
   void HandleLostData(int32_t size);
   void HandleFailure(int32_t size);
   void SetAvailableSize(const int64_t& available_size);
+  // Merges in the account-wide state of a copy of this account held elsewhere, e.g. one transferred
+  // to this node.  The claimed available size is taken from 'other' only if this account hasn't had
+  // one claimed.  Stored totals are left alone; they're credited per entry by AddTransferredValue.
+  void Merge(const PmidManagerMetadata& other);
+  // Credits the stored totals with a transferred entry which this account didn't hold.
+  void AddTransferredValue(const PmidManagerValue& value);
   std::string Serialise() const;
   detail::GroupDbMetaDataStatus GroupStatus();
 
@@ -48,12 +48,26 @@ inline bool ForThisPersona(const Message& message) {
 
 }  // namespace detail
 
-PmidManagerService::PmidManagerService(const passport::Pmid& pmid, routing::Routing& routing)
-    : routing_(routing), group_db_(), accumulator_mutex_(), accumulator_(), dispatcher_(routing_),
+PmidManagerService::PmidManagerService(const passport::Pmid& pmid, routing::Routing& routing,
+                                       const boost::filesystem::path& vault_root_dir)
+    : routing_(routing),
+      group_db_(detail::PersonaDbPath(vault_root_dir, "pmid_manager"),
+                detail::Parameters::pmid_manager_db_options),
+      accumulator_mutex_(),
+      accumulator_(detail::Parameters::pmid_manager_accumulator_options), dispatcher_(routing_),
       asio_service_(2), get_health_timer_(asio_service_), sync_puts_(NodeId(pmid.name()->string())),
       sync_deletes_(NodeId(pmid.name()->string())),
       sync_set_pmid_health_(NodeId(pmid.name()->string())),
-      sync_create_account_(NodeId(pmid.name()->string())) {
+      sync_create_account_(NodeId(pmid.name()->string())),
+      sync_retransmitters_() {
+  sync_retransmitters_.push_back(
+      detail::MakeSyncRetransmitter(asio_service_, dispatcher_, sync_puts_));
+  sync_retransmitters_.push_back(
+      detail::MakeSyncRetransmitter(asio_service_, dispatcher_, sync_deletes_));
+  sync_retransmitters_.push_back(
+      detail::MakeSyncRetransmitter(asio_service_, dispatcher_, sync_set_pmid_health_));
+  sync_retransmitters_.push_back(
+      detail::MakeSyncRetransmitter(asio_service_, dispatcher_, sync_create_account_));
 }
 
 
@@ -244,11 +258,24 @@ void PmidManagerService::HandleMessage(
     const typename SynchroniseFromPmidManagerToPmidManager::Sender& sender,
     const typename SynchroniseFromPmidManagerToPmidManager::Receiver& /*receiver*/) {
   LOG(kVerbose) << message;
-  protobuf::Sync proto_sync;
-  if (!proto_sync.ParseFromString(message.contents->data)) {
+  protobuf::SyncBatch proto_sync_batch;
+  if (!proto_sync_batch.ParseFromString(message.contents->data)) {
     LOG(kError) << "SynchroniseFromPmidManagerToPmidManager can't parse content";
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
   }
+  for (const auto& proto_sync : proto_sync_batch.syncs()) {
+    try {
+      HandleSync(proto_sync, sender);
+    }
+    catch (const maidsafe_error& error) {
+      LOG(kError) << "SynchroniseFromPmidManagerToPmidManager failed to handle action type "
+                  << proto_sync.action_type() << ": " << boost::diagnostic_information(error);
+    }
+  }
+}
+
+void PmidManagerService::HandleSync(const protobuf::Sync& proto_sync,
+                                    const routing::GroupSource& sender) {
   switch (static_cast<nfs::MessageAction>(proto_sync.action_type())) {
     case ActionPmidManagerPut::kActionId: {
       LOG(kVerbose) << "SynchroniseFromPmidManagerToPmidManager ActionPmidManagerPut";
@@ -326,9 +353,9 @@ void PmidManagerService::SendPutResponse(const DataNameVariant& data_name,
 void PmidManagerService::HandleSendPmidAccount(const PmidName& pmid_node, int64_t available_size) {
   std::vector<nfs_vault::DataName> data_names;
   try {
-    auto contents(group_db_.GetContents(pmid_node));
-    for (const auto& kv_pair : contents.kv_pairs)
-      data_names.push_back(nfs_vault::DataName(kv_pair.first.type, kv_pair.first.name));
+    group_db_.ForEachKey(pmid_node, [&data_names](const PmidManager::Key& key) {
+      data_names.push_back(nfs_vault::DataName(key.type, key.name));
+    });
     dispatcher_.SendPmidAccount(pmid_node, data_names,
                                 nfs_client::ReturnCode(CommonErrors::success));
     DoSync(PmidManager::UnresolvedSetPmidHealth(
@@ -483,13 +510,12 @@ void PmidManagerService::HandleChurnEvent(
   for (auto& node : lost_nodes) {
     try {
       auto pmid_node(PmidName(Identity(node.string())));
-      auto contents(group_db_.GetContents(pmid_node));
-      for (const auto& kv_pair : contents.kv_pairs) {
+      // Only the data names are needed, so the account's values are never read.
+      group_db_.ForEachKey(pmid_node, [&](const PmidManager::Key& key) {
         GLOG() << "PmidManager dropping pmid_node " << HexSubstr(node.string())
-               << " holding chunk " << HexSubstr(kv_pair.first.name);
-        auto data_name(nfs_vault::DataName(kv_pair.first.type, kv_pair.first.name));
-        dispatcher_.SendSetPmidOffline(data_name, pmid_node);
-      }
+               << " holding chunk " << HexSubstr(key.name);
+        dispatcher_.SendSetPmidOffline(nfs_vault::DataName(key.type, key.name), pmid_node);
+      });
     } catch (const maidsafe_error& error) {
       if (error.code() != make_error_code(VaultErrors::no_such_account))
         throw;
@@ -499,13 +525,11 @@ void PmidManagerService::HandleChurnEvent(
   for (auto& node : new_nodes) {
     try {
       auto pmid_node(PmidName(Identity(node.string())));
-      auto contents(group_db_.GetContents(PmidName(Identity(node.string()))));
-      for (const auto& kv_pair : contents.kv_pairs) {
+      group_db_.ForEachKey(pmid_node, [&](const PmidManager::Key& key) {
         GLOG() << "PmidManager joining pmid_node " << HexSubstr(node.string())
-               << " holding data " << HexSubstr(kv_pair.first.name);
-        auto data_name(nfs_vault::DataName(kv_pair.first.type, kv_pair.first.name));
-        dispatcher_.SendSetPmidOnline(data_name, pmid_node);
-      }
+               << " holding data " << HexSubstr(key.name);
+        dispatcher_.SendSetPmidOnline(nfs_vault::DataName(key.type, key.name), pmid_node);
+      });
     } catch (const maidsafe_error& error) {
       if (error.code() != make_error_code(VaultErrors::no_such_account))
         throw;
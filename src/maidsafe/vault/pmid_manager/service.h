@@ -41,6 +41,7 @@
 #include "maidsafe/vault/pmid_manager/dispatcher.h"
 #include "maidsafe/vault/pmid_manager/handler.h"
 #include "maidsafe/vault/sync.h"
+#include "maidsafe/vault/sync.pb.h"
 #include "maidsafe/vault/pmid_manager/pmid_manager.h"
 #include "maidsafe/vault/pmid_manager/metadata.h"
 #include "maidsafe/vault/operation_visitors.h"
@@ -61,7 +62,9 @@ class PmidManagerService {
   typedef PmidManagerServiceMessages Messages;
   typedef void HandleMessageReturnType;
 
-  PmidManagerService(const passport::Pmid& pmid, routing::Routing& routing);
+  // If 'vault_root_dir' is empty, the account db is not persisted.
+  PmidManagerService(const passport::Pmid& pmid, routing::Routing& routing,
+                     const boost::filesystem::path& vault_root_dir = boost::filesystem::path());
 
   template <typename MessageType>
   void HandleMessage(const MessageType& message, const typename MessageType::Sender& sender,
@@ -95,6 +98,9 @@ class PmidManagerService {
   PmidManagerService(PmidManagerService&&);
   PmidManagerService& operator=(PmidManagerService&&);
 
+  // Applies one action from a received batch of syncs.
+  void HandleSync(const protobuf::Sync& proto_sync, const routing::GroupSource& sender);
+
   template<typename ServiceHandlerType, typename MessageType>
   friend void detail::DoOperation(
       ServiceHandlerType* service, const MessageType& message,
@@ -149,6 +155,7 @@ class PmidManagerService {
   Sync<PmidManager::UnresolvedDelete> sync_deletes_;
   Sync<PmidManager::UnresolvedSetPmidHealth> sync_set_pmid_health_;
   Sync<PmidManager::UnresolvedCreateAccount> sync_create_account_;
+  std::vector<std::unique_ptr<detail::SyncRetransmitter>> sync_retransmitters_;
 };
 
 // ============================= Handle Message Specialisations ===================================
@@ -305,10 +312,7 @@ void PmidManagerService::HandleDelete(
 
 template <typename UnresolvedAction>
 void PmidManagerService::DoSync(const UnresolvedAction& unresolved_action) {
-  detail::IncrementAttemptsAndSendSync(dispatcher_, sync_puts_, unresolved_action);
-  detail::IncrementAttemptsAndSendSync(dispatcher_, sync_deletes_, unresolved_action);
-  detail::IncrementAttemptsAndSendSync(dispatcher_, sync_set_pmid_health_, unresolved_action);
-  detail::IncrementAttemptsAndSendSync(dispatcher_, sync_create_account_, unresolved_action);
+  detail::SendSyncAction(dispatcher_, unresolved_action);
 }
 
 // ===============================================================================================
@@ -62,6 +62,7 @@ PmidNodeService::PmidNodeService(const passport::Pmid& /*pmid*/, routing::Routin
 #ifdef USE_MAL_BEHAVIOUR
       malfunc_behaviour_seed_(RandomUint32()),
 #endif
+      accumulator_(detail::Parameters::pmid_node_accumulator_options),
       dispatcher_(routing_),
       handler_(vault_root_dir),
       active_(),
@@ -147,16 +148,16 @@ void PmidNodeService::HandleMessage(
                 << " from " << HexSubstr(sender.sender_id.data.string());
   typedef GetPmidAccountResponseFromPmidManagerToPmidNode MessageType;
   auto add_request_predicate(
-      [&](const std::vector<Messages>& requests_in) {
+      [&](const Accumulator<Messages>::Requests& requests_in) {
         assert(requests_in.size() <= std::numeric_limits<uint16_t>::max());
         const uint16_t requests_in_size(static_cast<uint16_t>(requests_in.size()));
         if (requests_in_size < 2)
           return Accumulator<Messages>::AddResult::kWaiting;
         uint16_t valid_response_size(0);
-        for (auto& request : requests_in) {
-          auto typed_request(boost::get<MessageType>(request));
+        for (size_t index(0); index != requests_in.distinct_size(); ++index) {
+          auto typed_request(boost::get<MessageType>(requests_in.distinct_at(index)));
           if (typed_request.contents->return_code.value.code() == CommonErrors::success)
-            ++valid_response_size;
+            valid_response_size += static_cast<uint16_t>(requests_in.vote_count(index));
         }
         const uint16_t& group_size(routing::Parameters::group_size);
         if (requests_in_size >= (group_size / 2 + 1U) && valid_response_size >= group_size / 2)
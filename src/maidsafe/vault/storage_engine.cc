@@ -0,0 +1,367 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault/storage_engine.h"
+
+#include <cassert>
+#include <mutex>
+#include <utility>
+
+#include "boost/filesystem/operations.hpp"
+#include "boost/thread/locks.hpp"
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+#include "maidsafe/vault/utils.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace detail {
+
+// ==================== LevelDbStorageEngine =======================================================
+LevelDbStorageEngine::LevelDbStorageEngine(const boost::filesystem::path& db_path,
+                                           bool persistent, const DbOptions& db_options)
+    : kDbPath_(db_path),
+      kPersistent_(persistent),
+      leveldb_(InitialiseLevelDb(kDbPath_, kPersistent_, db_options)) {}
+
+LevelDbStorageEngine::~LevelDbStorageEngine() {
+  if (kPersistent_)
+    return;
+  leveldb_.reset();
+  try {
+    leveldb::DestroyDB(kDbPath_.string(), leveldb::Options());
+    boost::filesystem::remove_all(kDbPath_);
+  } catch (const std::exception& e) {
+    LOG(kError) << "Failed to remove db : " << boost::diagnostic_information(e);
+  }
+}
+
+leveldb::Status LevelDbStorageEngine::Get(const leveldb::ReadOptions& options,
+                                          const leveldb::Slice& key, std::string* value) {
+  return leveldb_->Get(options, key, value);
+}
+
+leveldb::Status LevelDbStorageEngine::Put(const leveldb::Slice& key, const leveldb::Slice& value) {
+  return leveldb_->Put(leveldb::WriteOptions(), key, value);
+}
+
+leveldb::Status LevelDbStorageEngine::Delete(const leveldb::Slice& key) {
+  return leveldb_->Delete(leveldb::WriteOptions(), key);
+}
+
+leveldb::Status LevelDbStorageEngine::Write(leveldb::WriteBatch* batch) {
+  return leveldb_->Write(leveldb::WriteOptions(), batch);
+}
+
+leveldb::Iterator* LevelDbStorageEngine::NewIterator(const leveldb::ReadOptions& options) {
+  return leveldb_->NewIterator(options);
+}
+
+const leveldb::Snapshot* LevelDbStorageEngine::GetSnapshot() { return leveldb_->GetSnapshot(); }
+
+void LevelDbStorageEngine::ReleaseSnapshot(const leveldb::Snapshot* snapshot) {
+  leveldb_->ReleaseSnapshot(snapshot);
+}
+
+void LevelDbStorageEngine::CompactRange(const leveldb::Slice* begin, const leveldb::Slice* end) {
+  leveldb_->CompactRange(begin, end);
+}
+
+
+
+// ==================== InMemoryStorageEngine ======================================================
+class InMemoryStorageEngine::SequenceSnapshot : public leveldb::Snapshot {
+ public:
+  explicit SequenceSnapshot(Sequence sequence_in) : sequence(sequence_in) {}
+  virtual ~SequenceSnapshot() {}
+  const Sequence sequence;
+};
+
+// Holds its sequence for its whole lifetime, so the key it's positioned at is never pruned from
+// under it.  Keys and values are copied out, as the versions they're read from may be moved by
+// later writes.
+class InMemoryStorageEngine::TableIterator : public leveldb::Iterator {
+ public:
+  TableIterator(InMemoryStorageEngine& engine, Sequence sequence)
+      : engine_(engine), kSequence_(sequence), position_(engine.table_.end()), valid_(false),
+        key_(), value_() {}
+
+  virtual ~TableIterator() {
+    boost::unique_lock<boost::shared_mutex> lock(engine_.mutex_);
+    engine_.ReleaseSequence(kSequence_);
+  }
+
+  virtual bool Valid() const { return valid_; }
+
+  virtual void SeekToFirst() {
+    boost::shared_lock<boost::shared_mutex> lock(engine_.mutex_);
+    position_ = engine_.table_.begin();
+    SkipForward();
+  }
+
+  virtual void SeekToLast() {
+    boost::shared_lock<boost::shared_mutex> lock(engine_.mutex_);
+    position_ = engine_.table_.end();
+    SkipBackward();
+  }
+
+  virtual void Seek(const leveldb::Slice& target) {
+    boost::shared_lock<boost::shared_mutex> lock(engine_.mutex_);
+    position_ = engine_.table_.lower_bound(target.ToString());
+    SkipForward();
+  }
+
+  virtual void Next() {
+    assert(valid_);
+    boost::shared_lock<boost::shared_mutex> lock(engine_.mutex_);
+    ++position_;
+    SkipForward();
+  }
+
+  virtual void Prev() {
+    assert(valid_);
+    boost::shared_lock<boost::shared_mutex> lock(engine_.mutex_);
+    SkipBackward();
+  }
+
+  virtual leveldb::Slice key() const { return key_; }
+  virtual leveldb::Slice value() const { return value_; }
+  virtual leveldb::Status status() const { return leveldb::Status::OK(); }
+
+ private:
+  TableIterator(const TableIterator&);
+  TableIterator& operator=(const TableIterator&);
+
+  // Moves to the first visible key at or after 'position_'.
+  void SkipForward() {
+    for (; position_ != engine_.table_.end(); ++position_) {
+      if (SetCurrent())
+        return;
+    }
+    valid_ = false;
+  }
+
+  // Moves to the last visible key before 'position_'.
+  void SkipBackward() {
+    while (position_ != engine_.table_.begin()) {
+      --position_;
+      if (SetCurrent())
+        return;
+    }
+    position_ = engine_.table_.end();
+    valid_ = false;
+  }
+
+  bool SetCurrent() {
+    const Version* version(FindVisible(position_->second, kSequence_));
+    if (!version)
+      return false;
+    key_ = position_->first;
+    value_ = version->value;
+    valid_ = true;
+    return true;
+  }
+
+  InMemoryStorageEngine& engine_;
+  const Sequence kSequence_;
+  Table::const_iterator position_;
+  bool valid_;
+  std::string key_, value_;
+};
+
+class InMemoryStorageEngine::BatchHandler : public leveldb::WriteBatch::Handler {
+ public:
+  BatchHandler(InMemoryStorageEngine& engine, Sequence sequence)
+      : engine_(engine), kSequence_(sequence) {}
+  virtual void Put(const leveldb::Slice& key, const leveldb::Slice& value) {
+    engine_.Apply(key, &value, kSequence_);
+  }
+  virtual void Delete(const leveldb::Slice& key) { engine_.Apply(key, nullptr, kSequence_); }
+
+ private:
+  BatchHandler(const BatchHandler&);
+  BatchHandler& operator=(const BatchHandler&);
+
+  InMemoryStorageEngine& engine_;
+  const Sequence kSequence_;
+};
+
+InMemoryStorageEngine::Version::Version(Sequence sequence_in, bool deleted_in,
+                                        std::string value_in)
+    : sequence(sequence_in), deleted(deleted_in), value(std::move(value_in)) {}
+
+InMemoryStorageEngine::InMemoryStorageEngine()
+    : mutex_(), table_(), last_sequence_(0), live_sequences_(), unpruned_keys_(),
+      queued_keys_() {}
+
+InMemoryStorageEngine::~InMemoryStorageEngine() { assert(live_sequences_.empty()); }
+
+leveldb::Status InMemoryStorageEngine::Get(const leveldb::ReadOptions& options,
+                                           const leveldb::Slice& key, std::string* value) {
+  boost::shared_lock<boost::shared_mutex> lock(mutex_);
+  const Sequence sequence(options.snapshot ?
+      static_cast<const SequenceSnapshot*>(options.snapshot)->sequence : last_sequence_);
+  auto itr(table_.find(key.ToString()));
+  const Version* version(itr == table_.end() ? nullptr : FindVisible(itr->second, sequence));
+  if (!version)
+    return leveldb::Status::NotFound(key);
+  *value = version->value;
+  return leveldb::Status::OK();
+}
+
+leveldb::Status InMemoryStorageEngine::Put(const leveldb::Slice& key,
+                                           const leveldb::Slice& value) {
+  boost::unique_lock<boost::shared_mutex> lock(mutex_);
+  Apply(key, &value, ++last_sequence_);
+  return leveldb::Status::OK();
+}
+
+leveldb::Status InMemoryStorageEngine::Delete(const leveldb::Slice& key) {
+  boost::unique_lock<boost::shared_mutex> lock(mutex_);
+  Apply(key, nullptr, ++last_sequence_);
+  return leveldb::Status::OK();
+}
+
+// Every operation in the batch shares one sequence, so readers see all of them or none.
+leveldb::Status InMemoryStorageEngine::Write(leveldb::WriteBatch* batch) {
+  boost::unique_lock<boost::shared_mutex> lock(mutex_);
+  BatchHandler handler(*this, ++last_sequence_);
+  return batch->Iterate(&handler);
+}
+
+leveldb::Iterator* InMemoryStorageEngine::NewIterator(const leveldb::ReadOptions& options) {
+  boost::unique_lock<boost::shared_mutex> lock(mutex_);
+  return new TableIterator(*this, AcquireSequence(options.snapshot));
+}
+
+const leveldb::Snapshot* InMemoryStorageEngine::GetSnapshot() {
+  boost::unique_lock<boost::shared_mutex> lock(mutex_);
+  return new SequenceSnapshot(AcquireSequence(nullptr));
+}
+
+void InMemoryStorageEngine::ReleaseSnapshot(const leveldb::Snapshot* snapshot) {
+  const SequenceSnapshot* sequence_snapshot(static_cast<const SequenceSnapshot*>(snapshot));
+  {
+    boost::unique_lock<boost::shared_mutex> lock(mutex_);
+    ReleaseSequence(sequence_snapshot->sequence);
+  }
+  delete sequence_snapshot;
+}
+
+void InMemoryStorageEngine::CompactRange(const leveldb::Slice* begin, const leveldb::Slice* end) {
+  boost::unique_lock<boost::shared_mutex> lock(mutex_);
+  auto itr(begin ? table_.lower_bound(begin->ToString()) : table_.begin());
+  while (itr != table_.end() && (!end || leveldb::Slice(itr->first).compare(*end) < 0))
+    Prune(itr++);
+}
+
+const InMemoryStorageEngine::Version* InMemoryStorageEngine::FindVisible(
+    const std::vector<Version>& versions, Sequence sequence) {
+  for (auto itr(versions.rbegin()); itr != versions.rend(); ++itr) {
+    if (itr->sequence <= sequence)
+      return itr->deleted ? nullptr : &*itr;
+  }
+  return nullptr;
+}
+
+void InMemoryStorageEngine::Apply(const leveldb::Slice& key, const leveldb::Slice* value,
+                                  Sequence sequence) {
+  std::string key_string(key.ToString());
+  auto itr(table_.lower_bound(key_string));
+  if (itr == table_.end() || itr->first != key_string)
+    itr = table_.insert(itr, std::make_pair(key_string, std::vector<Version>()));
+  auto& versions(itr->second);
+  // A later operation on the same key within a batch replaces the earlier one.
+  if (!versions.empty() && versions.back().sequence == sequence)
+    versions.pop_back();
+  versions.push_back(Version(sequence, value == nullptr, value ? value->ToString() : ""));
+  // A key already queued keeps its earlier entry.  That entry can't be late, and if it's early
+  // ReleaseSequence just queues the key again.
+  const Sequence prunable_at(Prune(itr));
+  if (prunable_at != 0 && queued_keys_.insert(key_string).second)
+    unpruned_keys_.insert(std::make_pair(prunable_at, std::move(key_string)));
+}
+
+InMemoryStorageEngine::Sequence InMemoryStorageEngine::AcquireSequence(
+    const leveldb::Snapshot* snapshot) {
+  const Sequence sequence(snapshot ?
+      static_cast<const SequenceSnapshot*>(snapshot)->sequence : last_sequence_);
+  live_sequences_.insert(sequence);
+  return sequence;
+}
+
+void InMemoryStorageEngine::ReleaseSequence(Sequence sequence) {
+  auto itr(live_sequences_.find(sequence));
+  assert(itr != live_sequences_.end());
+  live_sequences_.erase(itr);
+  const Sequence oldest(live_sequences_.empty() ? last_sequence_ : *live_sequences_.begin());
+  while (!unpruned_keys_.empty() && unpruned_keys_.begin()->first <= oldest) {
+    std::string key(std::move(unpruned_keys_.begin()->second));
+    unpruned_keys_.erase(unpruned_keys_.begin());
+    queued_keys_.erase(key);
+    auto table_itr(table_.find(key));
+    if (table_itr == table_.end())
+      continue;
+    // Anything still unprunable is needed by a reader newer than 'oldest', so is queued later.
+    const Sequence prunable_at(Prune(table_itr));
+    if (prunable_at != 0) {
+      queued_keys_.insert(key);
+      unpruned_keys_.insert(std::make_pair(prunable_at, std::move(key)));
+    }
+  }
+}
+
+InMemoryStorageEngine::Sequence InMemoryStorageEngine::Prune(Table::iterator itr) {
+  const Sequence oldest(live_sequences_.empty() ? last_sequence_ : *live_sequences_.begin());
+  auto& versions(itr->second);
+  // The newest version at or before 'oldest' is seen by every reader which could see an older one.
+  size_t first_needed(0);
+  while (first_needed + 1 < versions.size() && versions[first_needed + 1].sequence <= oldest)
+    ++first_needed;
+  versions.erase(versions.begin(), versions.begin() + first_needed);
+  if (versions.size() == 1 && versions.front().deleted && versions.front().sequence <= oldest) {
+    table_.erase(itr);
+    return 0;
+  }
+  // The oldest version goes once every reader can see the next, and a lone deletion once every
+  // reader can see it.
+  if (versions.size() > 1)
+    return versions[1].sequence;
+  return versions.front().deleted ? versions.front().sequence : 0;
+}
+
+
+
+std::unique_ptr<StorageEngine> InitialiseStorageEngine(const boost::filesystem::path& db_path,
+                                                       bool persistent,
+                                                       const DbOptions& db_options) {
+  if (db_options.storage_engine == StorageEngineType::kInMemory) {
+    LOG(kInfo) << "Opening in-memory db";
+    return std::unique_ptr<StorageEngine>(new InMemoryStorageEngine);
+  }
+  return std::unique_ptr<StorageEngine>(new LevelDbStorageEngine(db_path, persistent, db_options));
+}
+
+}  // namespace detail
+
+}  // namespace vault
+
+}  // namespace maidsafe
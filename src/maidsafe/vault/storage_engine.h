@@ -0,0 +1,164 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_VAULT_STORAGE_ENGINE_H_
+#define MAIDSAFE_VAULT_STORAGE_ENGINE_H_
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "boost/filesystem/path.hpp"
+#include "boost/thread/shared_mutex.hpp"
+#include "leveldb/db.h"
+#include "leveldb/iterator.h"
+#include "leveldb/slice.h"
+#include "leveldb/status.h"
+#include "leveldb/write_batch.h"
+
+#include "maidsafe/vault/parameters.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace detail {
+
+// Ordered key-value store underlying Db and GroupDb.  This is the subset of leveldb::DB which
+// they use, and leveldb's own types are kept for keys, batches, iterators and snapshots.
+// Implementations are thread-safe.  An iterator sees the store as of its creation (or as of the
+// snapshot in its read options), and must be deleted before the engine.
+class StorageEngine {
+ public:
+  virtual ~StorageEngine() {}
+  // Returns a NotFound status if the key isn't in the store.
+  virtual leveldb::Status Get(const leveldb::ReadOptions& options, const leveldb::Slice& key,
+                              std::string* value) = 0;
+  virtual leveldb::Status Put(const leveldb::Slice& key, const leveldb::Slice& value) = 0;
+  virtual leveldb::Status Delete(const leveldb::Slice& key) = 0;
+  // Applies all of the batch's operations atomically.
+  virtual leveldb::Status Write(leveldb::WriteBatch* batch) = 0;
+  // The caller takes ownership of the returned iterator.
+  virtual leveldb::Iterator* NewIterator(const leveldb::ReadOptions& options) = 0;
+  virtual const leveldb::Snapshot* GetSnapshot() = 0;
+  virtual void ReleaseSnapshot(const leveldb::Snapshot* snapshot) = 0;
+  // Reclaims space held by deleted or overwritten entries in [begin, end).  A null 'begin' or 'end'
+  // means the start or end of the store.
+  virtual void CompactRange(const leveldb::Slice* begin, const leveldb::Slice* end) = 0;
+};
+
+class LevelDbStorageEngine : public StorageEngine {
+ public:
+  // If 'persistent' is false, any existing db at 'db_path' is replaced, and the db is destroyed
+  // along with this object.
+  LevelDbStorageEngine(const boost::filesystem::path& db_path, bool persistent,
+                       const DbOptions& db_options);
+  virtual ~LevelDbStorageEngine();
+  virtual leveldb::Status Get(const leveldb::ReadOptions& options, const leveldb::Slice& key,
+                              std::string* value);
+  virtual leveldb::Status Put(const leveldb::Slice& key, const leveldb::Slice& value);
+  virtual leveldb::Status Delete(const leveldb::Slice& key);
+  virtual leveldb::Status Write(leveldb::WriteBatch* batch);
+  virtual leveldb::Iterator* NewIterator(const leveldb::ReadOptions& options);
+  virtual const leveldb::Snapshot* GetSnapshot();
+  virtual void ReleaseSnapshot(const leveldb::Snapshot* snapshot);
+  virtual void CompactRange(const leveldb::Slice* begin, const leveldb::Slice* end);
+
+ private:
+  LevelDbStorageEngine(const LevelDbStorageEngine&);
+  LevelDbStorageEngine& operator=(const LevelDbStorageEngine&);
+
+  const boost::filesystem::path kDbPath_;
+  const bool kPersistent_;
+  std::unique_ptr<leveldb::DB> leveldb_;
+};
+
+// Sorted in-memory store, for tests, benchmarks and nodes which don't need their data to outlive
+// the process.  Each write is given a sequence number.  A key keeps older versions only while a
+// snapshot or iterator may still need them.
+class InMemoryStorageEngine : public StorageEngine {
+ public:
+  InMemoryStorageEngine();
+  virtual ~InMemoryStorageEngine();
+  virtual leveldb::Status Get(const leveldb::ReadOptions& options, const leveldb::Slice& key,
+                              std::string* value);
+  virtual leveldb::Status Put(const leveldb::Slice& key, const leveldb::Slice& value);
+  virtual leveldb::Status Delete(const leveldb::Slice& key);
+  virtual leveldb::Status Write(leveldb::WriteBatch* batch);
+  virtual leveldb::Iterator* NewIterator(const leveldb::ReadOptions& options);
+  virtual const leveldb::Snapshot* GetSnapshot();
+  virtual void ReleaseSnapshot(const leveldb::Snapshot* snapshot);
+  virtual void CompactRange(const leveldb::Slice* begin, const leveldb::Slice* end);
+
+ private:
+  typedef uint64_t Sequence;
+  struct Version {
+    Version(Sequence sequence_in, bool deleted_in, std::string value_in);
+    Sequence sequence;
+    bool deleted;
+    std::string value;
+  };
+  // Versions of each key are held oldest first.
+  typedef std::map<std::string, std::vector<Version>> Table;
+  class SequenceSnapshot;
+  class TableIterator;
+  class BatchHandler;
+
+  InMemoryStorageEngine(const InMemoryStorageEngine&);
+  InMemoryStorageEngine& operator=(const InMemoryStorageEngine&);
+  // All private functions below must be called with 'mutex_' held.
+  // Returns the version of 'versions' visible at 'sequence', or null if there is none or it is a
+  // deletion.
+  static const Version* FindVisible(const std::vector<Version>& versions, Sequence sequence);
+  // A null 'value' is a deletion.
+  void Apply(const leveldb::Slice& key, const leveldb::Slice* value, Sequence sequence);
+  // Registers a reader of 'snapshot', or of the latest state if 'snapshot' is null.
+  Sequence AcquireSequence(const leveldb::Snapshot* snapshot);
+  void ReleaseSequence(Sequence sequence);
+  // Drops versions no longer visible to any reader, and erases the key if it's deleted for all of
+  // them.  Returns the sequence the oldest reader must reach before more of the key can be pruned,
+  // or 0 if it has nothing left to prune.
+  Sequence Prune(Table::iterator itr);
+
+  mutable boost::shared_mutex mutex_;
+  Table table_;
+  Sequence last_sequence_;
+  // Sequences held by live snapshots and iterators
+  std::multiset<Sequence> live_sequences_;
+  // Keys left with stale versions because a reader still needed them, indexed by the sequence
+  // returned by Prune.  They're pruned as soon as the oldest live sequence reaches that.
+  std::multimap<Sequence, std::string> unpruned_keys_;
+  // Keys currently in 'unpruned_keys_', so each is queued at most once however often it's written.
+  std::set<std::string> queued_keys_;
+};
+
+// Creates the engine chosen in 'db_options'.  The in-memory engine ignores 'db_path'.
+std::unique_ptr<StorageEngine> InitialiseStorageEngine(const boost::filesystem::path& db_path,
+                                                       bool persistent,
+                                                       const DbOptions& db_options);
+
+}  // namespace detail
+
+}  // namespace vault
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_STORAGE_ENGINE_H_
@@ -21,13 +21,23 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <mutex>
+#include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "boost/functional/hash.hpp"
+
 #include "maidsafe/common/node_id.h"
 
+#include "maidsafe/vault/group_key.h"
+#include "maidsafe/vault/key.h"
+#include "maidsafe/vault/metadata_key.h"
+#include "maidsafe/vault/parameters.h"
+
 namespace maidsafe {
 
 namespace vault {
@@ -58,10 +68,15 @@ class Sync {
   // This returns all unresoved actions containing this node's ID.  Each returned unresolved_action
   // is provided
   // with just this node's ID inserted, even if the master copy has several other peers' IDs.
+  // With Parameters::delta_sync, an action also stops being returned once a majority of the group
+  // holds this node's entry, even if some peers' entries haven't been received.
   std::vector<std::unique_ptr<UnresolvedAction>> GetUnresolvedActions() const;
+  // True if GetUnresolvedActions() would return any actions, without copying them.
+  bool HasUnresolvedActions() const;
   // Calling this will increment the sync counter and delete actions that reach the
   // 'kSyncCounterMax_' limit.  Actions which are resolved by all peers (i.e. have 4 messages) are
-  // also pruned here.
+  // also pruned here, or with Parameters::delta_sync, once a majority of the group holds this
+  // node's entry.
   void IncrementSyncAttempts();
 
   static const nfs::MessageAction kActionId = UnresolvedAction::ActionType::kActionId;
@@ -70,10 +85,15 @@ class Sync {
   Sync(Sync&&);
   Sync(const Sync&);
   Sync& operator=(Sync other);
+  typedef std::vector<std::unique_ptr<UnresolvedAction>> UnresolvedActions;
+
   bool CanBeErased(const UnresolvedAction& unresolved_action) const;
+  static size_t KeyHash(const typename UnresolvedAction::KeyType& key);
 
   mutable std::mutex mutex_;
-  std::vector<std::unique_ptr<UnresolvedAction>> unresolved_actions_;
+  // Unresolved actions indexed by a hash of their key.  Each bucket is normally just the one or two
+  // actions for a single key, held in the order they were added.
+  std::unordered_map<size_t, UnresolvedActions> unresolved_actions_;
   NodeId node_id_;
   static const int32_t kSyncCounterMax_ = 10;  // TODO(dirvine) decide how to decide on this number.
 };
@@ -127,6 +147,44 @@ bool IsResolvedOnAllPeers(const UnresolvedAction& unresolved_action) {
   return result;
 }
 
+// True if a majority of the group, counting this node, holds this node's entry: the peers which
+// acknowledged it by listing this node in their syncs' seen lists.  Each of those peers also sent
+// its own entry, so the action has resolved here.
+template <typename UnresolvedAction>
+bool IsAcknowledgedByQuorum(const UnresolvedAction& unresolved_action) {
+  bool result(unresolved_action.this_node_and_entry_id &&
+              (unresolved_action.acknowledging_peers.size() + 1U >=
+                 (routing::Parameters::group_size / 2) + 1U));
+  LOG(kVerbose) << "IsAcknowledgedByQuorum " << result << " acknowledging_peers.size() : "
+                << unresolved_action.acknowledging_peers.size();
+  return result;
+}
+
+// The action is finished with once every peer's entry has been received.  In delta mode it's also
+// finished with once a majority holds this node's entry: the rest of the group can resolve the
+// action from that majority's entries, so resending this node's is no longer needed.
+template <typename UnresolvedAction>
+bool IsSyncComplete(const UnresolvedAction& unresolved_action) {
+  return IsResolvedOnAllPeers(unresolved_action) ||
+         (Parameters::delta_sync && IsAcknowledgedByQuorum(unresolved_action));
+}
+
+// A peer's sync acknowledges this node's entry if the peer lists this node in its seen list.
+template <typename UnresolvedAction>
+void RecordAcknowledgement(const UnresolvedAction& new_action, UnresolvedAction& existing_action,
+                           const NodeId& this_node_id) {
+  if (IsFromThisNode(new_action) || !existing_action.this_node_and_entry_id ||
+      !new_action.WasSeen(this_node_id)) {
+    return;
+  }
+  const NodeId& peer(new_action.peer_and_entry_ids.front().first);
+  if (std::find(std::begin(existing_action.acknowledging_peers),
+                std::end(existing_action.acknowledging_peers), peer) ==
+          std::end(existing_action.acknowledging_peers)) {
+    existing_action.acknowledging_peers.push_back(peer);
+  }
+}
+
 template <typename UnresolvedAction>
 void AppendUnresolvedActionEntry(const UnresolvedAction& new_action,
                                  UnresolvedAction& existing_action,
@@ -163,6 +221,28 @@ bool HaveEntryFromPeer(const UnresolvedAction& new_action,
   return false;
 }
 
+// Bucket hashes are built from the key fields rather than from Serialise(), so adding or looking
+// up an action doesn't pay for a protobuf serialisation.
+inline size_t HashSyncKey(const Key& key) {
+  size_t seed(0);
+  boost::hash_combine(seed, key.name.string());
+  boost::hash_combine(seed, static_cast<int32_t>(key.type));
+  return seed;
+}
+
+template <typename GroupName>
+size_t HashSyncKey(const MetadataKey<GroupName>& key) {
+  return std::hash<std::string>()(key.group_name()->string());
+}
+
+template <typename GroupName>
+size_t HashSyncKey(const GroupKey<GroupName>& key) {
+  size_t seed(HashSyncKey(key.metadata_key));
+  boost::hash_combine(seed, key.name.string());
+  boost::hash_combine(seed, static_cast<int32_t>(key.type));
+  return seed;
+}
+
 }  // namespace detail
 
 template <typename UnresolvedAction>
@@ -177,26 +257,30 @@ std::unique_ptr<UnresolvedAction> Sync<UnresolvedAction>::AddUnresolvedAction(
     const UnresolvedAction& unresolved_action) {
   std::lock_guard<std::mutex> lock(mutex_);
   std::unique_ptr<UnresolvedAction> resolved_action;
-  auto found(std::begin(unresolved_actions_));
+  auto& bucket(unresolved_actions_[KeyHash(unresolved_action.key)]);
+  auto found(std::begin(bucket));
   for (;;) {
-    found = std::find_if(found, std::end(unresolved_actions_),
+    found = std::find_if(found, std::end(bucket),
                          [&unresolved_action](const std::unique_ptr<UnresolvedAction>& test) {
                              return ((test->key == unresolved_action.key) &&
                                      (test->action == unresolved_action.action));
                          });
-    if (found == std::end(unresolved_actions_)) {  // not found
+    if (found == std::end(bucket)) {  // not found
       if (unresolved_action.WasSeen(node_id_)) {
         LOG(kWarning) << "AddAction " << kActionId << " received an async msg for erased entry";
+        if (bucket.empty())
+          unresolved_actions_.erase(KeyHash(unresolved_action.key));
         break;  // done here
       }
       LOG(kVerbose) << "AddAction " << kActionId << " inserted as first entry of unresolved";
-      detail::AddNewUnresolvedAction(unresolved_action, unresolved_actions_);
+      detail::AddNewUnresolvedAction(unresolved_action, bucket);
       break;  // done here
     }
 
     // found same action and key
     if (detail::IsRecorded(unresolved_action, (**found))) {
       LOG(kVerbose) << "AddAction " << kActionId << " dropped silently as it was recorded";
+      detail::RecordAcknowledgement(unresolved_action, **found, node_id_);
       break;  // done here
     }
     LOG(kVerbose) << "AddAction " << kActionId << " not recorded from the sender";
@@ -219,6 +303,7 @@ std::unique_ptr<UnresolvedAction> Sync<UnresolvedAction>::AddUnresolvedAction(
             !detail::HaveEntryFromPeer(unresolved_action, **found)) {
       LOG(kVerbose) << "AddAction " << kActionId << " appended to unresolved";
       detail::AppendUnresolvedActionEntry(unresolved_action, **found, resolved_action);
+      detail::RecordAcknowledgement(unresolved_action, **found, node_id_);
       break;
     }
 
@@ -232,37 +317,66 @@ std::vector<std::unique_ptr<UnresolvedAction>>
     Sync<UnresolvedAction>::GetUnresolvedActions() const {
   std::lock_guard<std::mutex> lock(mutex_);
   std::vector<std::unique_ptr<UnresolvedAction>> result;
-  for (const auto& unresolved_action : unresolved_actions_) {
-    if (detail::IsResolvedOnAllPeers(*unresolved_action))
-      continue;
-    if (detail::IsFromThisNode(*unresolved_action)) {
-      LOG(kVerbose) << "GetUnresolvedActions " << kActionId << " found one unresolved record";
-      std::unique_ptr<UnresolvedAction> action_ptr(new UnresolvedAction(*unresolved_action));
-      result.push_back(std::move(action_ptr));
+  for (const auto& bucket : unresolved_actions_) {
+    for (const auto& unresolved_action : bucket.second) {
+      if (detail::IsSyncComplete(*unresolved_action))
+        continue;
+      if (detail::IsFromThisNode(*unresolved_action)) {
+        LOG(kVerbose) << "GetUnresolvedActions " << kActionId << " found one unresolved record";
+        std::unique_ptr<UnresolvedAction> action_ptr(new UnresolvedAction(*unresolved_action));
+        result.push_back(std::move(action_ptr));
+      }
     }
   }
   return result;
 }
 
+template <typename UnresolvedAction>
+bool Sync<UnresolvedAction>::HasUnresolvedActions() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto& bucket : unresolved_actions_) {
+    for (const auto& unresolved_action : bucket.second) {
+      if (detail::IsFromThisNode(*unresolved_action) &&
+          !detail::IsSyncComplete(*unresolved_action)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
 template <typename UnresolvedAction>
 bool Sync<UnresolvedAction>::CanBeErased(const UnresolvedAction& unresolved_action) const {
   bool result(unresolved_action.sync_counter > kSyncCounterMax_ ||
-              detail::IsResolvedOnAllPeers(unresolved_action));
+              detail::IsSyncComplete(unresolved_action));
   LOG(kVerbose) << "Action " << kActionId << " CanBeErased " << result;
   return result;
 }
 
+template <typename UnresolvedAction>
+size_t Sync<UnresolvedAction>::KeyHash(const typename UnresolvedAction::KeyType& key) {
+  return detail::HashSyncKey(key);
+}
+
 template <typename UnresolvedAction>
 void Sync<UnresolvedAction>::IncrementSyncAttempts() {
   std::lock_guard<std::mutex> lock(mutex_);
-  auto itr = std::begin(unresolved_actions_);
-  while (itr != std::end(unresolved_actions_)) {
-    assert((*itr)->peer_and_entry_ids.size() <= routing::Parameters::group_size - 1U);
-    ++(*itr)->sync_counter;
-    if (CanBeErased(**itr))
-      itr = unresolved_actions_.erase(itr);
+  auto bucket_itr = std::begin(unresolved_actions_);
+  while (bucket_itr != std::end(unresolved_actions_)) {
+    auto& bucket(bucket_itr->second);
+    auto itr = std::begin(bucket);
+    while (itr != std::end(bucket)) {
+      assert((*itr)->peer_and_entry_ids.size() <= routing::Parameters::group_size - 1U);
+      ++(*itr)->sync_counter;
+      if (CanBeErased(**itr))
+        itr = bucket.erase(itr);
+      else
+        ++itr;
+    }
+    if (bucket.empty())
+      bucket_itr = unresolved_actions_.erase(bucket_itr);
     else
-      ++itr;
+      ++bucket_itr;
   }
 }
 
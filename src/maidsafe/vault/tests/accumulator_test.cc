@@ -24,6 +24,7 @@
 #include "maidsafe/common/utils.h"
 #include "maidsafe/common/data_types/data_type_values.h"
 #include "maidsafe/nfs/types.h"
+#include "maidsafe/nfs/client/messages.h"
 #include "maidsafe/nfs/client/messages.pb.h"
 #include "maidsafe/vault/message_types.h"
 #include "maidsafe/vault/pmid_manager/pmid_manager.pb.h"
@@ -84,7 +85,7 @@ TEST(AccumulatorTest, BEH_AddSingleResult) {
   GetPmidAccountResponseFromPmidManagerToPmidNode::Sender sender;
   routing::GroupSource group_source(sender.group_id, sender.sender_id);
 
-  auto add_request_predicate([&](const std::vector<PmidNodeServiceMessages>&) {
+  auto add_request_predicate([&](const Accumulator<PmidNodeServiceMessages>::Requests&) {
     return Accumulator<PmidNodeServiceMessages>::AddResult::kSuccess;
   });
 //   auto add_request_predicate(
@@ -105,7 +106,195 @@ TEST(AccumulatorTest, BEH_AddSingleResult) {
   EXPECT_EQ(Accumulator<PmidNodeServiceMessages>::AddResult::kSuccess,
             accumulator.AddPendingRequest(message, group_source, add_request_predicate));
 //   EXPECT_EQ(accumulator.pending_requests_.size(), 1);
-  EXPECT_FALSE(accumulator.CheckHandled(message));
+  EXPECT_FALSE(accumulator.CheckHandled(message, group_source));
+}
+
+TEST(AccumulatorTest, BEH_AddGroupRequests) {
+  typedef Accumulator<PmidNodeServiceMessages> PmidNodeAccumulator;
+  PmidNodeAccumulator accumulator;
+  GetPmidAccountResponseFromPmidManagerToPmidNode message;
+  GetPmidAccountResponseFromPmidManagerToPmidNode::Sender sender;
+  PmidNodeAccumulator::AddRequestChecker checker(3);
+  std::vector<routing::GroupSource> group_sources;
+  for (int i(0); i != 3; ++i) {
+    group_sources.push_back(routing::GroupSource(sender.group_id,
+                                                 routing::SingleId(NodeId(NodeId::kRandomId))));
+  }
+  EXPECT_EQ(PmidNodeAccumulator::AddResult::kWaiting,
+            accumulator.AddPendingRequest(message, group_sources.at(0), checker));
+  // A repeated request from the same sender isn't counted twice.
+  EXPECT_EQ(PmidNodeAccumulator::AddResult::kWaiting,
+            accumulator.AddPendingRequest(message, group_sources.at(0), checker));
+  EXPECT_EQ(PmidNodeAccumulator::AddResult::kWaiting,
+            accumulator.AddPendingRequest(message, group_sources.at(1), checker));
+  EXPECT_EQ(2U, accumulator.Get(message, group_sources.at(0)).size());
+  // The same message from another group is accumulated separately.
+  routing::GroupSource other_group_source(routing::GroupId(NodeId(NodeId::kRandomId)),
+                                          routing::SingleId(NodeId(NodeId::kRandomId)));
+  EXPECT_TRUE(accumulator.Get(message, other_group_source).empty());
+  EXPECT_EQ(PmidNodeAccumulator::AddResult::kWaiting,
+            accumulator.AddPendingRequest(message, other_group_source, checker));
+  EXPECT_EQ(PmidNodeAccumulator::AddResult::kSuccess,
+            accumulator.AddPendingRequest(message, group_sources.at(2), checker));
+}
+
+TEST(AccumulatorTest, BEH_VoteOnDistinctRequests) {
+  typedef Accumulator<PmidNodeServiceMessages> PmidNodeAccumulator;
+  PmidNodeAccumulator accumulator;
+  GetPmidAccountResponseFromPmidManagerToPmidNode message;
+  GetPmidAccountResponseFromPmidManagerToPmidNode failure(message);
+  failure.contents.reset(new nfs_client::DataNamesAndReturnCode(
+      std::vector<nfs_vault::DataName>(),
+      nfs_client::ReturnCode(MakeError(CommonErrors::unknown))));
+  GetPmidAccountResponseFromPmidManagerToPmidNode::Sender sender;
+  std::vector<routing::GroupSource> group_sources;
+  for (int i(0); i != 3; ++i) {
+    group_sources.push_back(routing::GroupSource(sender.group_id,
+                                                 routing::SingleId(NodeId(NodeId::kRandomId))));
+  }
+  PmidNodeAccumulator::AddRequestChecker quorum_checker(2);
+  size_t distinct_size(0), winner_vote_count(0);
+  bool failure_is_winner(false);
+  auto checker([&](const PmidNodeAccumulator::Requests& requests) {
+    distinct_size = requests.distinct_size();
+    winner_vote_count = requests.winner_vote_count();
+    failure_is_winner = (requests.winner() == PmidNodeServiceMessages(failure));
+    return quorum_checker(requests);
+  });
+  EXPECT_EQ(PmidNodeAccumulator::AddResult::kWaiting,
+            accumulator.AddPendingRequest(message, group_sources.at(0), checker));
+  // Two requests which differ don't make a quorum of two.
+  EXPECT_EQ(PmidNodeAccumulator::AddResult::kWaiting,
+            accumulator.AddPendingRequest(failure, group_sources.at(1), checker));
+  EXPECT_EQ(2U, distinct_size);
+  EXPECT_EQ(1U, winner_vote_count);
+  EXPECT_FALSE(failure_is_winner);
+  EXPECT_EQ(PmidNodeAccumulator::AddResult::kSuccess,
+            accumulator.AddPendingRequest(message, group_sources.at(2), checker));
+  EXPECT_EQ(2U, distinct_size);
+  EXPECT_EQ(2U, winner_vote_count);
+  EXPECT_FALSE(failure_is_winner);
+  auto requests(accumulator.Get(message, group_sources.at(0)));
+  ASSERT_EQ(3U, requests.size());
+  EXPECT_TRUE(requests.at(0) == requests.at(2));
+  EXPECT_FALSE(requests.at(0) == requests.at(1));
+}
+
+TEST(AccumulatorTest, BEH_SetHandled) {
+  typedef Accumulator<PmidNodeServiceMessages> PmidNodeAccumulator;
+  PmidNodeAccumulator accumulator;
+  GetPmidAccountResponseFromPmidManagerToPmidNode message;
+  message.id = nfs::MessageId(0);
+  GetPmidAccountResponseFromPmidManagerToPmidNode::Sender sender;
+  PmidNodeAccumulator::AddRequestChecker checker(1);
+  routing::GroupSource group_source(sender.group_id, routing::SingleId(NodeId(NodeId::kRandomId)));
+  EXPECT_EQ(PmidNodeAccumulator::AddResult::kSuccess,
+            accumulator.AddPendingRequest(message, group_source, checker));
+  EXPECT_FALSE(accumulator.CheckHandled(message, group_source));
+  accumulator.SetHandled(message, group_source);
+  EXPECT_TRUE(accumulator.CheckHandled(message, group_source));
+  EXPECT_TRUE(accumulator.Get(message, group_source).empty());
+  // A late request from the rest of the group is dropped.
+  routing::GroupSource late_source(sender.group_id, routing::SingleId(NodeId(NodeId::kRandomId)));
+  EXPECT_EQ(PmidNodeAccumulator::AddResult::kHandled,
+            accumulator.AddPendingRequest(message, late_source, checker));
+  EXPECT_TRUE(accumulator.Get(message, late_source).empty());
+
+  // Only the latest 1000 handled messages are remembered.
+  GetPmidAccountResponseFromPmidManagerToPmidNode other_message(message);
+  for (int32_t i(1); i != 1000; ++i) {
+    other_message.id = nfs::MessageId(i);
+    accumulator.SetHandled(other_message, group_source);
+  }
+  EXPECT_TRUE(accumulator.CheckHandled(message, group_source));
+  other_message.id = nfs::MessageId(1000);
+  accumulator.SetHandled(other_message, group_source);
+  EXPECT_FALSE(accumulator.CheckHandled(message, group_source));
+  EXPECT_TRUE(accumulator.CheckHandled(other_message, group_source));
+
+  // With a limit of 0, no handled messages are remembered.
+  detail::AccumulatorOptions options;
+  options.max_handled_requests_count = 0;
+  PmidNodeAccumulator forgetful_accumulator(options);
+  EXPECT_EQ(PmidNodeAccumulator::AddResult::kSuccess,
+            forgetful_accumulator.AddPendingRequest(message, group_source, checker));
+  forgetful_accumulator.SetHandled(message, group_source);
+  EXPECT_FALSE(forgetful_accumulator.CheckHandled(message, group_source));
+  EXPECT_TRUE(forgetful_accumulator.Get(message, group_source).empty());
+}
+
+TEST(AccumulatorTest, BEH_SetHandledPerGroup) {
+  typedef Accumulator<PmidNodeServiceMessages> PmidNodeAccumulator;
+  PmidNodeAccumulator accumulator;
+  GetPmidAccountResponseFromPmidManagerToPmidNode message;
+  message.id = nfs::MessageId(0);
+  PmidNodeAccumulator::AddRequestChecker checker(1);
+  // The same message id, sent by two groups.
+  routing::GroupSource group_source(routing::GroupId(NodeId(NodeId::kRandomId)),
+                                    routing::SingleId(NodeId(NodeId::kRandomId)));
+  routing::GroupSource other_group_source(routing::GroupId(NodeId(NodeId::kRandomId)),
+                                          routing::SingleId(NodeId(NodeId::kRandomId)));
+  EXPECT_EQ(PmidNodeAccumulator::AddResult::kSuccess,
+            accumulator.AddPendingRequest(message, group_source, checker));
+  accumulator.SetHandled(message, group_source);
+  EXPECT_TRUE(accumulator.CheckHandled(message, group_source));
+  // Handling the first group's message doesn't stop the second group's from being accumulated.
+  EXPECT_FALSE(accumulator.CheckHandled(message, other_group_source));
+  EXPECT_EQ(PmidNodeAccumulator::AddResult::kSuccess,
+            accumulator.AddPendingRequest(message, other_group_source, checker));
+  EXPECT_EQ(1U, accumulator.Get(message, other_group_source).size());
+  accumulator.SetHandled(message, other_group_source);
+  EXPECT_TRUE(accumulator.CheckHandled(message, other_group_source));
+  EXPECT_EQ(PmidNodeAccumulator::AddResult::kHandled,
+            accumulator.AddPendingRequest(message, group_source, checker));
+}
+
+TEST(AccumulatorTest, BEH_PendingRequestLimits) {
+  typedef Accumulator<PmidNodeServiceMessages> PmidNodeAccumulator;
+  GetPmidAccountResponseFromPmidManagerToPmidNode message, other_message;
+  message.id = nfs::MessageId(0);
+  other_message.id = nfs::MessageId(1);
+  GetPmidAccountResponseFromPmidManagerToPmidNode::Sender sender;
+  routing::GroupSource group_source(sender.group_id, routing::SingleId(NodeId(NodeId::kRandomId)));
+  PmidNodeAccumulator::AddRequestChecker checker(2);
+  {
+    // Requests expire once their message's lifetime has passed.
+    detail::AccumulatorOptions options;
+    options.pending_request_lifetime = std::chrono::steady_clock::duration::zero();
+    PmidNodeAccumulator accumulator(options);
+    EXPECT_EQ(PmidNodeAccumulator::AddResult::kWaiting,
+              accumulator.AddPendingRequest(message, group_source, checker));
+    EXPECT_EQ(1U, accumulator.Get(message, group_source).size());
+    EXPECT_EQ(PmidNodeAccumulator::AddResult::kWaiting,
+              accumulator.AddPendingRequest(other_message, group_source, checker));
+    EXPECT_TRUE(accumulator.Get(message, group_source).empty());
+    EXPECT_EQ(1U, accumulator.Get(other_message, group_source).size());
+  }
+  {
+    // The oldest message is dropped once the requests' size exceeds the budget, but the latest
+    // message is always kept.
+    detail::AccumulatorOptions options;
+    options.max_pending_requests_size = 1;
+    PmidNodeAccumulator accumulator(options);
+    EXPECT_EQ(PmidNodeAccumulator::AddResult::kWaiting,
+              accumulator.AddPendingRequest(message, group_source, checker));
+    EXPECT_EQ(1U, accumulator.Get(message, group_source).size());
+    EXPECT_EQ(PmidNodeAccumulator::AddResult::kWaiting,
+              accumulator.AddPendingRequest(other_message, group_source, checker));
+    EXPECT_TRUE(accumulator.Get(message, group_source).empty());
+    EXPECT_EQ(1U, accumulator.Get(other_message, group_source).size());
+  }
+  {
+    detail::AccumulatorOptions options;
+    options.max_pending_requests_count = 1;
+    PmidNodeAccumulator accumulator(options);
+    EXPECT_EQ(PmidNodeAccumulator::AddResult::kWaiting,
+              accumulator.AddPendingRequest(message, group_source, checker));
+    EXPECT_EQ(PmidNodeAccumulator::AddResult::kWaiting,
+              accumulator.AddPendingRequest(other_message, group_source, checker));
+    EXPECT_TRUE(accumulator.Get(message, group_source).empty());
+    EXPECT_EQ(1U, accumulator.Get(other_message, group_source).size());
+  }
 }
 
 
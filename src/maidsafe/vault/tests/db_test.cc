@@ -22,6 +22,7 @@
 #include "leveldb/options.h"
 
 #include "leveldb/status.h"
+#include "leveldb/write_batch.h"
 
 #include "maidsafe/common/log.h"
 #include "maidsafe/common/test.h"
@@ -31,6 +32,7 @@
 
 #include "maidsafe/vault/data_manager/value.h"
 #include "maidsafe/vault/key.h"
+#include "maidsafe/vault/storage_engine.h"
 #include "maidsafe/vault/version_handler/value.h"
 
 namespace maidsafe {
@@ -130,8 +132,165 @@ TEST_CASE("Db transfer info", "[Db][Unit]") {
   Db<Key, DataManagerValue> data_manager_db;
   Db<Key, VersionHandlerValue> version_handler_db;
   std::shared_ptr<routing::MatrixChange> matrix_change;
-  data_manager_db.GetTransferInfo(matrix_change);
-  version_handler_db.GetTransferInfo(matrix_change);
+  data_manager_db.GetTransferInfo(matrix_change,
+      [](const NodeId&, std::vector<Db<Key, DataManagerValue>::SerialisedKvPair>) {});
+  version_handler_db.GetTransferInfo(matrix_change,
+      [](const NodeId&, std::vector<Db<Key, VersionHandlerValue>::SerialisedKvPair>) {});
+}
+
+TEST_CASE("Db persistence", "[Db][Unit]") {
+  const maidsafe::test::TestPath kTestRoot(maidsafe::test::CreateTestPath("MaidSafe_Test_Vault"));
+  const boost::filesystem::path kDbPath(*kTestRoot / "db");
+  Key key(Identity(NodeId(NodeId::kRandomId).string()), DataTagValue::kMaidValue);
+  {
+    Db<Key, TestDbValue> db(kDbPath);
+    db.Commit(key, TestDbActionPutValue("new_value"));
+  }
+  CHECK(boost::filesystem::exists(kDbPath));
+  {
+    Db<Key, TestDbValue> db(kDbPath);
+    CHECK(db.Get(key).value == "new_value");
+    CHECK(db.MayExist(key));
+    db.Commit(key, TestDbActionDeleteValue());
+  }
+  Db<Key, TestDbValue> db(kDbPath);
+  CHECK_THROWS_AS(db.Get(key), maidsafe_error);
+}
+
+TEST_CASE("Db TryGet and Exists", "[Db][Unit]") {
+  Db<Key, TestDbValue> db;
+  Key key(Identity(NodeId(NodeId::kRandomId).string()), DataTagValue::kMaidValue);
+  CHECK_FALSE(db.TryGet(key));
+  CHECK_FALSE(db.Exists(key));
+  CHECK_FALSE(db.MayExist(key));
+  db.Commit(key, TestDbActionPutValue("new_value"));
+  CHECK(db.MayExist(key));
+  auto value(db.TryGet(key));
+  REQUIRE(value);
+  CHECK(value->value == "new_value");
+  CHECK(db.Exists(key));
+  db.Commit(key, TestDbActionDeleteValue());
+  CHECK_FALSE(db.TryGet(key));
+  CHECK_FALSE(db.Exists(key));
+}
+
+TEST_CASE("Db cache", "[Db][Unit]") {
+  Db<Key, TestDbValue> db(boost::filesystem::path(), detail::DbOptions(), 2);
+  Key key(Identity(NodeId(NodeId::kRandomId).string()), DataTagValue::kMaidValue);
+  CHECK_FALSE(db.TryGet(key));
+  db.Commit(key, TestDbActionPutValue("new_value"));
+  CHECK(db.TryGet(key)->value == "new_value");
+  CHECK(db.GetCacheStats().hits == 1U);
+  db.Commit(key, TestDbActionModifyValue("modified_value"));
+  CHECK(db.TryGet(key)->value == "modified_value");
+  db.Commit(key, TestDbActionDeleteValue());
+  CHECK_FALSE(db.TryGet(key));
+  // Evicted values are re-read from the db.
+  std::vector<Key> keys;
+  for (int i(0); i != 3; ++i) {
+    keys.push_back(Key(Identity(NodeId(NodeId::kRandomId).string()), DataTagValue::kMaidValue));
+    db.Commit(keys.back(), TestDbActionPutValue("new_value"));
+  }
+  const auto misses(db.GetCacheStats().misses);
+  CHECK(db.TryGet(keys.front())->value == "new_value");
+  CHECK(db.GetCacheStats().misses == misses + 1);
+}
+
+TEST_CASE("Db handle transfer", "[Db][Unit]") {
+  Db<Key, TestDbValue> db;
+  Key existing_key(Identity(NodeId(NodeId::kRandomId).string()), DataTagValue::kMaidValue);
+  Key new_key(Identity(NodeId(NodeId::kRandomId).string()), DataTagValue::kMaidValue);
+  db.Commit(existing_key, TestDbActionPutValue("existing_value"));
+  std::vector<Db<Key, TestDbValue>::SerialisedKvPair> contents;
+  contents.push_back(std::make_pair(existing_key, std::string("transferred_value")));
+  contents.push_back(std::make_pair(new_key, std::string("transferred_value")));
+  db.HandleTransfer(contents);
+  CHECK(db.Get(existing_key).value == "existing_value");
+  CHECK(db.Get(new_key).value == "transferred_value");
+}
+
+TEST_CASE("Db in-memory engine", "[Db][Unit]") {
+  detail::DbOptions db_options;
+  db_options.storage_engine = detail::StorageEngineType::kInMemory;
+  Db<Key, TestDbValue> db(boost::filesystem::path(), db_options);
+  Key key(Identity(NodeId(NodeId::kRandomId).string()), DataTagValue::kMaidValue);
+  for (auto i(0); i != 100; ++i)
+    DbTests(db, key);
+  PopulateDbValues(db, 1000);
+  CHECK_FALSE(db.Exists(key));
+  db.Commit(key, TestDbActionPutValue("new_value"));
+  CHECK(db.Exists(key));
+}
+
+TEST_CASE("Db merge", "[Db][Unit]") {
+  Db<Key, DataManagerValue> db;
+  Key key(Identity(NodeId(NodeId::kRandomId).string()), DataTagValue::kMaidValue);
+  const std::string kIncrement(detail::MergeOperator<DataManagerValue>::MakeOperand(1));
+  // Operands for a missing value are dropped.
+  db.Merge(key, kIncrement);
+  CHECK_FALSE(db.TryGet(key));
+  CHECK_FALSE(db.Exists(key));
+  db.Commit(key, [](std::unique_ptr<DataManagerValue>& value) {
+    value.reset(new DataManagerValue(PmidName(Identity(NodeId(NodeId::kRandomId).string())), 100));
+    return detail::DbAction::kPut;
+  });
+  db.Merge(key, kIncrement);
+  db.Merge(key, kIncrement);
+  CHECK(db.Get(key).Subscribers() == 3);
+  CHECK(db.Exists(key));
+  // Enough operands for merges to fold them back into the value twice over
+  const size_t kMergeCount(2 * Parameters::max_pending_merge_operands + 1);
+  for (size_t i(0); i != kMergeCount; ++i)
+    db.Merge(key, kIncrement);
+  const int64_t kSubscribers(3 + static_cast<int64_t>(kMergeCount));
+  CHECK(db.Get(key).Subscribers() == kSubscribers);
+  CHECK(db.Get(key).Subscribers() == kSubscribers);
+  db.Merge(key, detail::MergeOperator<DataManagerValue>::MakeOperand(-kSubscribers));
+  CHECK_FALSE(db.TryGet(key));
+  CHECK_FALSE(db.Exists(key));
+
+  // Operands left on a missing value aren't applied to a value transferred in later.
+  Key transferred_key(Identity(NodeId(NodeId::kRandomId).string()), DataTagValue::kMaidValue);
+  db.Merge(transferred_key, kIncrement);
+  std::vector<Db<Key, DataManagerValue>::SerialisedKvPair> contents;
+  contents.push_back(std::make_pair(transferred_key, DataManagerValue(
+      PmidName(Identity(NodeId(NodeId::kRandomId).string())), 100).Serialise()));
+  db.HandleTransfer(contents);
+  CHECK(db.Get(transferred_key).Subscribers() == 1);
+}
+
+TEST_CASE("InMemoryStorageEngine snapshots", "[Db][Unit]") {
+  detail::InMemoryStorageEngine engine;
+  std::string value;
+  REQUIRE(engine.Put("a", "1").ok());
+  REQUIRE(engine.Put("b", "2").ok());
+  const leveldb::Snapshot* snapshot(engine.GetSnapshot());
+  REQUIRE(engine.Delete("a").ok());
+  leveldb::WriteBatch batch;
+  batch.Put("b", "3");
+  batch.Put("c", "4");
+  REQUIRE(engine.Write(&batch).ok());
+  CHECK(engine.Get(leveldb::ReadOptions(), "a", &value).IsNotFound());
+  CHECK((engine.Get(leveldb::ReadOptions(), "b", &value).ok() && value == "3"));
+
+  leveldb::ReadOptions read_options;
+  read_options.snapshot = snapshot;
+  CHECK((engine.Get(read_options, "a", &value).ok() && value == "1"));
+  std::string contents;
+  {
+    std::unique_ptr<leveldb::Iterator> iter(engine.NewIterator(read_options));
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next())
+      contents += iter->key().ToString() + iter->value().ToString();
+  }
+  CHECK(contents == "a1b2");
+  engine.ReleaseSnapshot(snapshot);
+
+  contents.clear();
+  engine.CompactRange(nullptr, nullptr);
+  std::unique_ptr<leveldb::Iterator> iter(engine.NewIterator(leveldb::ReadOptions()));
+  for (iter->Seek("a"); iter->Valid(); iter->Next())
+    contents += iter->key().ToString() + iter->value().ToString();
+  CHECK(contents == "b3c4");
 }
 
 // parallel test
@@ -343,12 +343,202 @@ TEST(GroupDbTest, FUNC_PmidManagerGroupDb) {
   });
 }
 
+TEST(GroupDbTest, FUNC_InMemoryEngine) {
+  detail::DbOptions db_options;
+  db_options.storage_engine = detail::StorageEngineType::kInMemory;
+  GroupDb<MaidManager> maid_group_db(boost::filesystem::path(), db_options);
+  GroupDb<PmidManager> pmid_group_db(boost::filesystem::path(), db_options);
+  RunDbTestInParallel(10, [&] {
+    RunMaidManagerGroupDbTest(maid_group_db);
+    RunPmidManagerGroupDbTest(pmid_group_db);
+  });
+}
+
+TEST(GroupDbTest, BEH_Persistence) {
+  const maidsafe::test::TestPath kTestRoot(maidsafe::test::CreateTestPath("MaidSafe_Test_Vault"));
+  const boost::filesystem::path kDbPath(*kTestRoot / "group_db");
+  auto maid(MakeMaid());
+  MaidName maid_name(maid.name());
+  auto metadata(CreateMaidManagerMetadata(maid));
+  GroupKey<MaidName> key(maid_name, Identity(NodeId(NodeId::kRandomId).string()),
+                         DataTagValue::kMaidValue);
+  MaidManagerMetadata expected_metadata(metadata);
+  expected_metadata.PutData(100);
+  MaidManagerValue expected_value;
+  expected_value.Put(100);
+  {
+    GroupDb<MaidManager> maid_group_db(kDbPath);
+    maid_group_db.AddGroup(maid_name, metadata);
+    maid_group_db.Commit(key, TestGroupDbActionPutValue());
+  }
+  {
+    GroupDb<MaidManager> maid_group_db(kDbPath);
+    EXPECT_TRUE(maid_group_db.GetMetadata(maid_name) == expected_metadata);
+    EXPECT_TRUE(maid_group_db.GetValue(key) == expected_value);
+    EXPECT_EQ(1U, maid_group_db.GetContents(maid_name).kv_pairs.size());
+    EXPECT_THROW(maid_group_db.AddGroup(maid_name, metadata), maidsafe_error);
+    maid_group_db.DeleteGroup(maid_name);
+  }
+  GroupDb<MaidManager> maid_group_db(kDbPath);
+  EXPECT_THROW(maid_group_db.GetMetadata(maid_name), maidsafe_error);
+}
+
+TEST(GroupDbTest, BEH_TryGetValueAndExists) {
+  GroupDb<PmidManager> pmid_group_db;
+  PmidName pmid_name(Identity(NodeId(NodeId::kRandomId).string()));
+  GroupKey<PmidName> key(pmid_name, Identity(NodeId(NodeId::kRandomId).string()),
+                         DataTagValue::kPmidValue);
+  EXPECT_FALSE(pmid_group_db.TryGetValue(key));
+  EXPECT_FALSE(pmid_group_db.Exists(key));
+  pmid_group_db.AddGroup(pmid_name, CreatePmidManagerMetadata(pmid_name));
+  EXPECT_FALSE(pmid_group_db.TryGetValue(key));
+  EXPECT_FALSE(pmid_group_db.Exists(key));
+  pmid_group_db.Commit(key, TestPmidGroupDbActionPutValue());
+  auto value(pmid_group_db.TryGetValue(key));
+  ASSERT_TRUE(value != nullptr);
+  EXPECT_TRUE(*value == PmidManagerValue(100));
+  EXPECT_TRUE(pmid_group_db.Exists(key));
+}
+
+TEST(GroupDbTest, BEH_ForEachKey) {
+  GroupDb<PmidManager> pmid_group_db;
+  PmidName pmid_name(Identity(NodeId(NodeId::kRandomId).string()));
+  auto collect_keys([&](std::vector<GroupKey<PmidName>>& keys) {
+    pmid_group_db.ForEachKey(pmid_name, [&keys](const GroupKey<PmidName>& key) {
+      keys.push_back(key);
+    });
+  });
+  std::vector<GroupKey<PmidName>> keys;
+  EXPECT_THROW(collect_keys(keys), maidsafe_error);
+  pmid_group_db.AddGroup(pmid_name, CreatePmidManagerMetadata(pmid_name));
+  collect_keys(keys);
+  EXPECT_TRUE(keys.empty());
+
+  std::vector<GroupKey<PmidName>> expected_keys;
+  for (auto i(0); i < 10; ++i) {
+    expected_keys.push_back(GroupKey<PmidName>(
+        pmid_name, Identity(NodeId(NodeId::kRandomId).string()), DataTagValue::kPmidValue));
+    pmid_group_db.Commit(expected_keys.back(), TestPmidGroupDbActionPutValue());
+  }
+  collect_keys(keys);
+  ASSERT_EQ(expected_keys.size(), keys.size());
+  for (const auto& key : expected_keys)
+    EXPECT_TRUE(std::find(keys.begin(), keys.end(), key) != keys.end());
+}
+
+TEST(GroupDbTest, BEH_Merge) {
+  GroupDb<MaidManager> maid_group_db;
+  auto maid(MakeMaid());
+  MaidName maid_name(maid.name());
+  auto metadata(CreateMaidManagerMetadata(maid));
+  GroupKey<MaidName> key(maid_name, Identity(NodeId(NodeId::kRandomId).string()),
+                         DataTagValue::kMaidValue);
+  maid_group_db.AddGroup(maid_name, metadata);
+  maid_group_db.Merge(key, detail::MergeOperator<MaidManagerValue>::MakeOperand(1, 100),
+                      [](MaidManagerMetadata& metadata) { metadata.PutData(100); });
+  MaidManagerMetadata expected_metadata(metadata);
+  expected_metadata.PutData(100);
+  MaidManagerValue expected_value;
+  expected_value.Put(100);
+  EXPECT_TRUE(maid_group_db.GetMetadata(maid_name) == expected_metadata);
+  EXPECT_TRUE(maid_group_db.GetValue(key) == expected_value);
+
+  maid_group_db.Merge(key, detail::MergeOperator<MaidManagerValue>::MakeOperand(1, 0));
+  expected_value.IncrementCount();
+  EXPECT_TRUE(maid_group_db.GetValue(key) == expected_value);
+  auto contents(maid_group_db.GetContents(maid_name));
+  ASSERT_EQ(1U, contents.kv_pairs.size());
+  EXPECT_TRUE(contents.kv_pairs.front().second == expected_value);
+  // A commit folds the pending operands in before applying its action.
+  maid_group_db.Commit(key, TestGroupDbActionModifyValue());
+  expected_value.Put(100);
+  EXPECT_TRUE(maid_group_db.GetValue(key) == expected_value);
+
+  maid_group_db.Merge(key, detail::MergeOperator<MaidManagerValue>::MakeOperand(-3, 0));
+  EXPECT_FALSE(maid_group_db.Exists(key));
+  EXPECT_FALSE(maid_group_db.TryGetValue(key));
+  EXPECT_TRUE(maid_group_db.GetContents(maid_name).kv_pairs.empty());
+}
+
+TEST(GroupDbTest, FUNC_ManyGroups) {
+  // More groups than a 2 byte group id prefix could address, with ids released and reused.
+  GroupDb<PmidManager> pmid_group_db;
+  std::vector<PmidName> pmid_names;
+  for (auto i(0); i < 70000; ++i) {
+    pmid_names.push_back(PmidName(Identity(NodeId(NodeId::kRandomId).string())));
+    pmid_group_db.AddGroup(pmid_names.back(), PmidManagerMetadata(pmid_names.back()));
+  }
+  for (auto i(0); i < 100; ++i)
+    pmid_group_db.DeleteGroup(pmid_names.at(i));
+  for (auto i(0); i < 100; ++i)
+    pmid_group_db.AddGroup(pmid_names.at(i), PmidManagerMetadata(pmid_names.at(i)));
+  for (const auto& pmid_name : pmid_names)
+    EXPECT_TRUE(pmid_group_db.GetMetadata(pmid_name) == PmidManagerMetadata(pmid_name));
+}
+
 TEST(GroupDbTest, BEH_TransferInfo) {
   GroupDb<MaidManager> maid_group_db;
   GroupDb<PmidManager> pmid_group_db;
   std::shared_ptr<routing::MatrixChange> matrix_change;
-  maid_group_db.GetTransferInfo(matrix_change);
-  pmid_group_db.GetTransferInfo(matrix_change);
+  maid_group_db.GetTransferInfo(matrix_change,
+      [](const NodeId&, std::vector<GroupDb<MaidManager>::TransferContents>) {});
+  pmid_group_db.GetTransferInfo(matrix_change,
+      [](const NodeId&, std::vector<GroupDb<PmidManager>::TransferContents>) {});
+}
+
+TEST(GroupDbTest, BEH_HandleTransferIntoExistingGroup) {
+  typedef GroupDb<PmidManager>::TransferContents TransferContents;
+  GroupDb<PmidManager> pmid_group_db;
+  PmidName pmid_name(Identity(NodeId(NodeId::kRandomId).string()));
+  auto make_key([&] {
+    return GroupKey<PmidName>(pmid_name, Identity(NodeId(NodeId::kRandomId).string()),
+                              DataTagValue::kPmidValue);
+  });
+  // The account was created here on a put before the transfer arrived.
+  PmidManagerMetadata local_metadata(pmid_name);
+  pmid_group_db.AddGroup(pmid_name, local_metadata);
+  const auto kLocalKey(make_key()), kTransferredKey(make_key()), kContinuationKey(make_key());
+  pmid_group_db.Commit(kLocalKey, TestPmidGroupDbActionPutValue());
+  local_metadata.PutData(100);
+
+  TransferContents contents;
+  contents.group_name = pmid_name;
+  contents.metadata = PmidManagerMetadata(pmid_name);
+  contents.metadata.PutData(50);
+  contents.metadata.PutData(70);
+  contents.metadata.SetAvailableSize(1000);
+  contents.kv_pairs.push_back(std::make_pair(kLocalKey, PmidManagerValue(50).Serialise()));
+  contents.kv_pairs.push_back(std::make_pair(kTransferredKey, PmidManagerValue(70).Serialise()));
+  pmid_group_db.HandleTransfer(std::vector<TransferContents>(1, contents));
+  // Local entries are kept, and only the entries written are credited to the metadata.
+  EXPECT_TRUE(pmid_group_db.GetValue(kLocalKey) == PmidManagerValue(100));
+  EXPECT_TRUE(pmid_group_db.GetValue(kTransferredKey) == PmidManagerValue(70));
+  PmidManagerMetadata expected_metadata(local_metadata);
+  expected_metadata.PutData(70);
+  expected_metadata.SetAvailableSize(1000);
+  EXPECT_EQ(2, expected_metadata.stored_count);
+  EXPECT_EQ(170, expected_metadata.stored_total_size);
+  EXPECT_TRUE(pmid_group_db.GetMetadata(pmid_name) == expected_metadata);
+
+  // A continuation chunk of the same transfer likewise only adds the entries the group lacks.
+  contents.kv_pairs.assign(1, std::make_pair(kContinuationKey, PmidManagerValue(30).Serialise()));
+  contents.kv_pairs.push_back(std::make_pair(kLocalKey, PmidManagerValue(50).Serialise()));
+  contents.continuation = true;
+  pmid_group_db.HandleTransfer(std::vector<TransferContents>(1, contents));
+  EXPECT_TRUE(pmid_group_db.GetValue(kContinuationKey) == PmidManagerValue(30));
+  EXPECT_TRUE(pmid_group_db.GetValue(kLocalKey) == PmidManagerValue(100));
+  expected_metadata.PutData(30);
+  EXPECT_TRUE(pmid_group_db.GetMetadata(pmid_name) == expected_metadata);
+
+  // A group new to the receiver ends up with the sender's totals once all its entries arrive.
+  GroupDb<PmidManager> new_pmid_group_db;
+  contents.kv_pairs.assign(1, std::make_pair(kLocalKey, PmidManagerValue(50).Serialise()));
+  contents.continuation = false;
+  new_pmid_group_db.HandleTransfer(std::vector<TransferContents>(1, contents));
+  contents.kv_pairs.assign(1, std::make_pair(kTransferredKey, PmidManagerValue(70).Serialise()));
+  contents.continuation = true;
+  new_pmid_group_db.HandleTransfer(std::vector<TransferContents>(1, contents));
+  EXPECT_TRUE(new_pmid_group_db.GetMetadata(pmid_name) == contents.metadata);
 }
 
 }  // namespace test
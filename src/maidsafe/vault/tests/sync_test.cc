@@ -30,6 +30,7 @@
 
 #include "maidsafe/vault/group_db.h"
 #include "maidsafe/common/log.h"
+#include "maidsafe/common/on_scope_exit.h"
 #include "maidsafe/common/test.h"
 #include "maidsafe/common/utils.h"
 
@@ -141,6 +142,7 @@ TEST(SyncTest, BEH_SingleAction) {
         EXPECT_TRUE(resolved->action == unresolved_actions[0].action);
       }
       auto unresolved_list = persona_nodes[i]->sync.GetUnresolvedActions();
+      EXPECT_EQ(!unresolved_list.empty(), persona_nodes[i]->sync.HasUnresolvedActions());
       if ((j >= i) && (j < (routing::Parameters::group_size -1U)))
         EXPECT_TRUE(unresolved_list.size() == 1U) << "i = " << i << " , j = " << j;;
     }
@@ -331,6 +333,50 @@ TEST(SyncTest, BEH_MultipleParallelRandomAction) {
   ApplySyncToPersona(persona_node, keys);
 }
 
+TEST(SyncTest, BEH_DeltaSync) {
+  const bool kDeltaSync(detail::Parameters::delta_sync);
+  on_scope_exit restore_delta_sync([&] { detail::Parameters::delta_sync = kDeltaSync; });
+  detail::Parameters::delta_sync = true;
+  auto maid(MakeMaid());
+  passport::PublicMaid::Name maid_name(MaidName(maid.name()));
+  typedef std::unique_ptr<PersonaNode<MaidManager::UnresolvedPut>> PersonaNodePtr;
+  std::vector<PersonaNodePtr> persona_nodes(routing::Parameters::group_size);
+  std::generate(std::begin(persona_nodes), std::end(persona_nodes),
+                [] { return PersonaNodePtr(new PersonaNodePtr::element_type); });
+
+  MaidManager::Key key(maid_name, Identity(NodeId(NodeId::kRandomId).string()),
+                       DataTagValue::kMaidValue);
+  std::vector<MaidManager::UnresolvedPut> unresolved_actions;
+  for (const auto& persona_node : persona_nodes)
+    unresolved_actions.push_back(persona_node->CreateUnresolvedAction(key));
+
+  // Node 0's entry is resent until, with node 0 itself, the peers which have acknowledged it make
+  // a majority of the group.
+  persona_nodes[0]->ReceiveUnresolvedAction(unresolved_actions[0]);
+  auto resend_acknowledging_entry([&](size_t i) {
+    persona_nodes[i]->ReceiveUnresolvedAction(unresolved_actions[i]);
+    persona_nodes[i]->ReceiveUnresolvedAction(unresolved_actions[0]);
+    auto peer_actions(persona_nodes[i]->sync.GetUnresolvedActions());
+    ASSERT_EQ(1U, peer_actions.size());
+    persona_nodes[0]->ReceiveUnresolvedAction(*peer_actions.front());
+  });
+  const size_t kQuorumPeers(routing::Parameters::group_size / 2);
+  for (size_t i(1); i != kQuorumPeers; ++i) {
+    resend_acknowledging_entry(i);
+    persona_nodes[0]->sync.IncrementSyncAttempts();
+    EXPECT_EQ(1U, persona_nodes[0]->sync.GetUnresolvedActions().size());
+  }
+  resend_acknowledging_entry(kQuorumPeers);
+  EXPECT_EQ(1, persona_nodes[0]->resolved_count);
+  EXPECT_TRUE(persona_nodes[0]->sync.GetUnresolvedActions().empty());
+  // Without delta sync, it would be resent until the remaining peers' entries arrive.
+  detail::Parameters::delta_sync = false;
+  EXPECT_EQ(1U, persona_nodes[0]->sync.GetUnresolvedActions().size());
+  detail::Parameters::delta_sync = true;
+  persona_nodes[0]->sync.IncrementSyncAttempts();
+  EXPECT_TRUE(persona_nodes[0]->sync.GetUnresolvedActions().empty());
+}
+
 }  // namespace test
 
 }  // namespace vault
@@ -16,17 +16,27 @@
     See the Licences for the specific language governing permissions and limitations relating to
     use of the MaidSafe Software.                                                                 */
 
+#include <atomic>
+#include <chrono>
 #include <functional>
+#include <map>
 #include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include "boost/filesystem/operations.hpp"
 #include "boost/filesystem/path.hpp"
 #include "boost/thread/future.hpp"
 
+#include "maidsafe/common/asio_service.h"
+#include "maidsafe/common/on_scope_exit.h"
 #include "maidsafe/common/test.h"
 #include "maidsafe/common/utils.h"
 #include "maidsafe/passport/types.h"
 
+#include "maidsafe/vault/group_key.h"
 #include "maidsafe/vault/utils.h"
 #include "maidsafe/vault/vault.h"
 
@@ -67,6 +77,173 @@ TEST(UtilsTest, BEH_FixedWidthStringSize3) { CheckToAndFromFixedWidthString<3>()
 
 TEST(UtilsTest, BEH_FixedWidthStringSize4) { CheckToAndFromFixedWidthString<4>(); }
 
+TEST(UtilsTest, BEH_FixedWidthKey) {
+  const uint32_t kNumber(RandomUint32() % (1 << 24));
+  detail::FixedWidthKey<3> key;
+  detail::EncodeFixedWidth<3>(kNumber, key.data());
+  const leveldb::Slice key_slice(key);
+  EXPECT_EQ(detail::ToFixedWidthString<3>(kNumber), key_slice.ToString());
+  EXPECT_EQ(kNumber, detail::DecodeFixedWidth<3>(key_slice.data()));
+  // Copies just the leading bytes of a longer key.
+  const std::string kLongerKey(key_slice.ToString() + RandomString(10));
+  const detail::FixedWidthKey<3> copied_key((leveldb::Slice(kLongerKey)));
+  EXPECT_TRUE(leveldb::Slice(copied_key) == key_slice);
+}
+
+TEST(UtilsTest, BEH_ExistenceFilter) {
+  // Keys added concurrently are all found, and few keys never added are.
+  detail::ExistenceFilter existence_filter(1 << 16);
+  std::vector<std::string> keys, other_keys;
+  for (int i(0); i != 4000; ++i) {
+    keys.push_back(RandomString(64));
+    other_keys.push_back(RandomString(64));
+  }
+  std::vector<std::thread> threads;
+  for (size_t thread_index(0); thread_index != 4; ++thread_index) {
+    threads.push_back(std::thread([&, thread_index] {
+      for (size_t i(thread_index); i < keys.size(); i += 4)
+        existence_filter.Add(keys[i]);
+    }));
+  }
+  for (auto& thread : threads)
+    thread.join();
+  for (const auto& key : keys)
+    EXPECT_TRUE(existence_filter.MayContain(key));
+  int false_positive_count(0);
+  for (const auto& key : other_keys) {
+    if (existence_filter.MayContain(key))
+      ++false_positive_count;
+  }
+  EXPECT_LT(false_positive_count, 100);
+}
+
+TEST(UtilsTest, BEH_SyncRetransmitter) {
+  const auto kInterval(detail::Parameters::sync_retransmission_interval);
+  const auto kMaxInterval(detail::Parameters::max_sync_retransmission_interval);
+  on_scope_exit restore_intervals([&] {
+    detail::Parameters::sync_retransmission_interval = kInterval;
+    detail::Parameters::max_sync_retransmission_interval = kMaxInterval;
+  });
+  detail::Parameters::sync_retransmission_interval = std::chrono::milliseconds(10);
+  detail::Parameters::max_sync_retransmission_interval = std::chrono::milliseconds(20);
+
+  AsioService asio_service(1);
+  std::atomic<int> call_count(0);
+  {
+    detail::SyncRetransmitter retransmitter(asio_service, [&] {
+      ++call_count;
+      return true;
+    });
+    Sleep(std::chrono::milliseconds(200));
+  }
+  const int kCallCount(call_count);
+  // At most every 20ms, after backing off from 10ms.
+  EXPECT_GE(kCallCount, 3);
+  EXPECT_LE(kCallCount, 12);
+  // Nothing runs once the retransmitter is destroyed.
+  Sleep(std::chrono::milliseconds(100));
+  EXPECT_EQ(kCallCount, call_count);
+}
+
+namespace {
+
+struct TestSyncKey {
+  Identity name;
+};
+
+typedef GroupKey<MaidName> TestSyncGroupKey;
+
+std::string TestSyncGroupName(const TestSyncKey& key) { return key.name.string(); }
+
+std::string TestSyncGroupName(const TestSyncGroupKey& key) { return key.group_name()->string(); }
+
+struct TestSyncAction {
+  static const nfs::MessageAction kActionId = nfs::MessageAction::kPutVersionRequest;
+};
+
+template <typename KeyType>
+struct TestUnresolvedAction {
+  std::string Serialise() const { return serialised; }
+  KeyType key;
+  TestSyncAction action;
+  std::string serialised;
+};
+
+struct TestSyncDispatcher {
+  template <typename KeyType>
+  void SendSync(const KeyType& key, const std::string& serialised_sync) {
+    protobuf::SyncBatch proto_sync_batch;
+    ASSERT_TRUE(proto_sync_batch.ParseFromString(serialised_sync));
+    auto& group_batches(sent[TestSyncGroupName(key)]);
+    group_batches.push_back(std::vector<std::string>());
+    for (const auto& proto_sync : proto_sync_batch.syncs())
+      group_batches.back().push_back(proto_sync.serialised_unresolved_action());
+  }
+  // Per group, the serialised actions of each message sent to it
+  std::map<std::string, std::vector<std::vector<std::string>>> sent;
+};
+
+// Sends six actions, all but the second to 'key0', with batches of at most three.
+template <typename KeyType>
+void CheckSendSyncBatches(const KeyType& key0, const KeyType& key1) {
+  const size_t kMaxBatchCount(detail::Parameters::max_sync_batch_count);
+  on_scope_exit restore_max_batch_count([&] {
+    detail::Parameters::max_sync_batch_count = kMaxBatchCount;
+  });
+  detail::Parameters::max_sync_batch_count = 3;
+
+  std::vector<std::unique_ptr<TestUnresolvedAction<KeyType>>> unresolved_actions;
+  for (int i(0); i != 6; ++i) {
+    std::unique_ptr<TestUnresolvedAction<KeyType>> unresolved_action(
+        new TestUnresolvedAction<KeyType>);
+    unresolved_action->key = (i == 1 ? key1 : key0);
+    unresolved_action->serialised = std::to_string(i);
+    unresolved_actions.push_back(std::move(unresolved_action));
+  }
+
+  TestSyncDispatcher dispatcher;
+  detail::SendSync(dispatcher, unresolved_actions);
+  ASSERT_EQ(2U, dispatcher.sent.size());
+  // Five actions for the first group go in a full batch and a remainder, in order.
+  const auto& group0_batches(dispatcher.sent[TestSyncGroupName(key0)]);
+  ASSERT_EQ(2U, group0_batches.size());
+  EXPECT_EQ((std::vector<std::string>{"0", "2", "3"}), group0_batches[0]);
+  EXPECT_EQ((std::vector<std::string>{"4", "5"}), group0_batches[1]);
+  const auto& group1_batches(dispatcher.sent[TestSyncGroupName(key1)]);
+  ASSERT_EQ(1U, group1_batches.size());
+  EXPECT_EQ(std::vector<std::string>(1, "1"), group1_batches[0]);
+}
+
+}  // unnamed namespace
+
+TEST(UtilsTest, BEH_SendSyncBatches) {
+  TestSyncKey key0, key1;
+  key0.name = Identity(RandomString(64));
+  key1.name = Identity(RandomString(64));
+  CheckSendSyncBatches(key0, key1);
+}
+
+TEST(UtilsTest, BEH_SendSyncBatchesByGroupName) {
+  const MaidName kGroup0(Identity(RandomString(64))), kGroup1(Identity(RandomString(64)));
+  TestSyncGroupKey key0(kGroup0, Identity(RandomString(64)), DataTagValue::kMaidValue);
+  TestSyncGroupKey key1(kGroup1, Identity(RandomString(64)), DataTagValue::kMaidValue);
+  CheckSendSyncBatches(key0, key1);
+  // Only the group name decides the batch, so differently named keys of one group share it.
+  std::vector<std::unique_ptr<TestUnresolvedAction<TestSyncGroupKey>>> unresolved_actions;
+  for (int i(0); i != 2; ++i) {
+    std::unique_ptr<TestUnresolvedAction<TestSyncGroupKey>> unresolved_action(
+        new TestUnresolvedAction<TestSyncGroupKey>);
+    unresolved_action->key =
+        TestSyncGroupKey(kGroup0, Identity(RandomString(64)), DataTagValue::kMaidValue);
+    unresolved_action->serialised = std::to_string(i);
+    unresolved_actions.push_back(std::move(unresolved_action));
+  }
+  TestSyncDispatcher dispatcher;
+  detail::SendSync(dispatcher, unresolved_actions);
+  ASSERT_EQ(1U, dispatcher.sent.size());
+  EXPECT_EQ((std::vector<std::string>{"0", "1"}), dispatcher.sent[kGroup0->string()].at(0));
+}
+
 }  // namespace test
 
 }  // namespace vault
@@ -51,6 +51,9 @@ struct UnresolvedAction {
   Action action;
   std::shared_ptr<std::pair<NodeId, int32_t>> this_node_and_entry_id;
   std::vector<std::pair<NodeId, int32_t>> peer_and_entry_ids;
+  // Peers whose syncs have listed this node's entry as seen.  Only meaningful if this node has an
+  // entry.
+  std::vector<NodeId> acknowledging_peers;
   int sync_counter;
 
  private:
@@ -108,6 +111,7 @@ UnresolvedAction<Key, Action>::UnresolvedAction(const std::string& serialised_co
       action(ParseAction<Action>(serialised_copy)),
       this_node_and_entry_id(),
       peer_and_entry_ids(),
+      acknowledging_peers(),
       sync_counter(0),
       seen_list() {
   protobuf::UnresolvedAction proto_unresolved_action;
@@ -129,6 +133,7 @@ UnresolvedAction<Key, Action>::UnresolvedAction(const UnresolvedAction& other)
       action(other.action),
       this_node_and_entry_id(),
       peer_and_entry_ids(other.peer_and_entry_ids),
+      acknowledging_peers(other.acknowledging_peers),
       sync_counter(other.sync_counter),
       seen_list(other.seen_list) {
   if (other.this_node_and_entry_id)
@@ -143,6 +148,7 @@ UnresolvedAction<Key, Action>::UnresolvedAction(UnresolvedAction&& other)
       action(std::move(other.action)),
       this_node_and_entry_id(std::move(other.this_node_and_entry_id)),
       peer_and_entry_ids(std::move(other.peer_and_entry_ids)),
+      acknowledging_peers(std::move(other.acknowledging_peers)),
       sync_counter(std::move(other.sync_counter)),
       seen_list(std::move(other.seen_list)) {}
 
@@ -157,6 +163,7 @@ UnresolvedAction<Key, Action>::UnresolvedAction(const Key& key_in, const Action&
             return std::make_pair(this_node_id, ++entry_id_sequence_number);
           }())),
       peer_and_entry_ids(),
+      acknowledging_peers(),
       sync_counter(0),
       seen_list() {}
 
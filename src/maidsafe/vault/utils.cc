@@ -18,11 +18,25 @@
 
 #include "maidsafe/vault/utils.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <ios>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 
+#include "boost/exception/diagnostic_information.hpp"
 #include "boost/filesystem/operations.hpp"
+#include "leveldb/cache.h"
+#include "leveldb/filter_policy.h"
 #include "leveldb/status.h"
 
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
 #include "maidsafe/common/types.h"
 #include "maidsafe/nfs/types.h"
 #include "maidsafe/vault/parameters.h"
@@ -121,20 +135,180 @@ void InitialiseDirectory(const boost::filesystem::path& directory) {
   }
 }
 
+boost::filesystem::path PersonaDbPath(const boost::filesystem::path& vault_root_dir,
+                                      const std::string& persona_dir_name) {
+  if (vault_root_dir.empty())
+    return boost::filesystem::path();
+  return vault_root_dir / "db" / persona_dir_name;
+}
+
 bool ShouldRetry(routing::Routing& routing, const NodeId& source_id, const NodeId& data_name) {
   return routing.network_status() >= Parameters::kMinNetworkHealth &&
          routing.EstimateInGroup(source_id, data_name);
 }
 
+DbBatchWriter::DbBatchWriter(StorageEngine& db) : db_(db), batch_(), count_(0) {}
+
+void DbBatchWriter::Put(const leveldb::Slice& key, const leveldb::Slice& value) {
+  batch_.Put(key, value);
+  FlushIfFull();
+}
+
+void DbBatchWriter::Delete(const leveldb::Slice& key) {
+  batch_.Delete(key);
+  FlushIfFull();
+}
+
+void DbBatchWriter::Flush() {
+  if (count_ == 0)
+    return;
+  leveldb::Status status(db_.Write(&batch_));
+  if (!status.ok()) {
+    LOG(kError) << "DbBatchWriter::Flush failed to write " << count_ << " entries : "
+                << status.ToString();
+    BOOST_THROW_EXCEPTION(MakeError(VaultErrors::failed_to_handle_request));
+  }
+  batch_.Clear();
+  count_ = 0;
+}
+
+void DbBatchWriter::FlushIfFull() {
+  if (++count_ >= Parameters::max_db_write_batch_count)
+    Flush();
+}
+
+namespace {
+
+// 64-bit FNV-1a, which hashes the key in place rather than needing it copied into a std::string.
+uint64_t HashKey(const leveldb::Slice& key) {
+  uint64_t hash(14695981039346656037ULL);
+  for (size_t i(0); i != key.size(); ++i) {
+    hash ^= static_cast<unsigned char>(key[i]);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+}  // unnamed namespace
+
+ExistenceFilter::ExistenceFilter(size_t bit_count)
+    : kBitCount_(bit_count),
+      words_(new std::atomic<uint64_t>[(bit_count + 63) / 64]),
+      set_bit_count_(0),
+      saturation_logged_(false) {
+  assert(bit_count != 0);
+  for (size_t i(0); i != (kBitCount_ + 63) / 64; ++i)
+    words_[i].store(0, std::memory_order_relaxed);
+}
+
+// The two halves of a single hash are combined to give the kHashCount_ bit positions.  Bits are
+// set with release ordering before the key's write is made, and read with acquire ordering.
+void ExistenceFilter::Add(const leveldb::Slice& key) {
+  const uint64_t hash(HashKey(key));
+  const uint32_t hash1(static_cast<uint32_t>(hash)), hash2(static_cast<uint32_t>(hash >> 32));
+  for (int i(0); i != kHashCount_; ++i) {
+    const uint64_t bit((hash1 + static_cast<uint64_t>(i) * hash2) % kBitCount_);
+    const uint64_t mask(uint64_t(1) << (bit % 64));
+    if ((words_[bit / 64].fetch_or(mask, std::memory_order_release) & mask) == 0 &&
+        ++set_bit_count_ == kBitCount_ / 2 && !saturation_logged_.exchange(true)) {
+      LOG(kWarning) << "ExistenceFilter of " << kBitCount_ << " bits is half full; lookups will "
+                    << "increasingly miss it.  Raise Parameters::db_existence_filter_bits.";
+    }
+  }
+}
+
+bool ExistenceFilter::MayContain(const leveldb::Slice& key) const {
+  const uint64_t hash(HashKey(key));
+  const uint32_t hash1(static_cast<uint32_t>(hash)), hash2(static_cast<uint32_t>(hash >> 32));
+  for (int i(0); i != kHashCount_; ++i) {
+    const uint64_t bit((hash1 + static_cast<uint64_t>(i) * hash2) % kBitCount_);
+    if ((words_[bit / 64].load(std::memory_order_acquire) & (uint64_t(1) << (bit % 64))) == 0)
+      return false;
+  }
+  return true;
+}
+
+std::string MakeMergeOperandKey(const leveldb::Slice& db_key, uint64_t sequence) {
+  static_assert(MergeSequenceWidth::value == 8, "sequence is written as two 4 byte halves");
+  std::string operand_key(db_key.size() + MergeSequenceWidth::value, 0);
+  std::memcpy(&operand_key[0], db_key.data(), db_key.size());
+  EncodeFixedWidth<4>(static_cast<uint32_t>(sequence >> 32), &operand_key[db_key.size()]);
+  EncodeFixedWidth<4>(static_cast<uint32_t>(sequence), &operand_key[db_key.size() + 4]);
+  return operand_key;
+}
+
+// The value's operands sort directly after it, so its last one is the entry before the highest
+// possible operand key.
+uint64_t NextMergeSequence(leveldb::Iterator& db_iter, const leveldb::Slice& db_key) {
+  const std::string last_operand_key(
+      MakeMergeOperandKey(db_key, std::numeric_limits<uint64_t>::max()));
+  db_iter.Seek(last_operand_key);
+  if (db_iter.Valid())
+    db_iter.Prev();
+  else
+    db_iter.SeekToLast();
+  if (!db_iter.status().ok())
+    BOOST_THROW_EXCEPTION(MakeError(VaultErrors::failed_to_handle_request));
+  if (!db_iter.Valid() || !db_iter.key().starts_with(db_key) ||
+      db_iter.key().size() != db_key.size() + MergeSequenceWidth::value) {
+    return 0;
+  }
+  const char* sequence(db_iter.key().data() + db_key.size());
+  return ((static_cast<uint64_t>(DecodeFixedWidth<4>(sequence)) << 32) |
+          DecodeFixedWidth<4>(sequence + 4)) + 1;
+}
+
 }  // namespace detail
 
-std::unique_ptr<leveldb::DB> InitialiseLevelDb(const boost::filesystem::path& db_path) {
-  if (boost::filesystem::exists(db_path))
+namespace {
+
+// Block caches and filter policies are shared by all dbs configured alike, so are kept for the
+// lifetime of the process.
+leveldb::Cache* SharedBlockCache(size_t block_cache_size) {
+  static std::mutex mutex;
+  static std::map<size_t, std::unique_ptr<leveldb::Cache>> block_caches;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto& block_cache(block_caches[block_cache_size]);
+  if (!block_cache)
+    block_cache.reset(leveldb::NewLRUCache(block_cache_size));
+  return block_cache.get();
+}
+
+const leveldb::FilterPolicy* SharedBloomFilterPolicy(int bits_per_key) {
+  static std::mutex mutex;
+  static std::map<int, std::unique_ptr<const leveldb::FilterPolicy>> filter_policies;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto& filter_policy(filter_policies[bits_per_key]);
+  if (!filter_policy)
+    filter_policy.reset(leveldb::NewBloomFilterPolicy(bits_per_key));
+  return filter_policy.get();
+}
+
+}  // unnamed namespace
+
+std::unique_ptr<leveldb::DB> InitialiseLevelDb(const boost::filesystem::path& db_path,
+                                               bool reuse_existing,
+                                               const detail::DbOptions& db_options) {
+  if (reuse_existing)
+    boost::filesystem::create_directories(db_path);
+  else if (boost::filesystem::exists(db_path))
     boost::filesystem::remove_all(db_path);
   leveldb::DB* db(nullptr);
   leveldb::Options options;
   options.create_if_missing = true;
-  options.error_if_exists = true;
+  options.error_if_exists = !reuse_existing;
+  options.block_cache = SharedBlockCache(db_options.block_cache_size);
+  options.write_buffer_size = db_options.write_buffer_size;
+  if (db_options.bloom_filter_bits_per_key > 0)
+    options.filter_policy = SharedBloomFilterPolicy(db_options.bloom_filter_bits_per_key);
+  options.compression =
+      db_options.compression ? leveldb::kSnappyCompression : leveldb::kNoCompression;
+  LOG(kInfo) << "Opening db at " << db_path << " with block cache size "
+             << db_options.block_cache_size << ", write buffer size "
+             << db_options.write_buffer_size << ", bloom filter bits per key "
+             << db_options.bloom_filter_bits_per_key << ", compression "
+             << std::boolalpha << db_options.compression << ", verify checksums "
+             << db_options.verify_checksums;
   leveldb::Status status(leveldb::DB::Open(options, db_path.string(), &db));
   if (!status.ok())
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
@@ -142,6 +316,57 @@ std::unique_ptr<leveldb::DB> InitialiseLevelDb(const boost::filesystem::path& db
   return std::move(std::unique_ptr<leveldb::DB>(db));
 }
 
+namespace detail {
+
+SyncRetransmitter::State::State(AsioService& asio_service, std::function<bool()> retransmit_in)
+    : mutex(),
+      stopped(false),
+      timer(asio_service.service()),
+      interval(Parameters::sync_retransmission_interval),
+      retransmit(retransmit_in) {}
+
+SyncRetransmitter::SyncRetransmitter(AsioService& asio_service, std::function<bool()> retransmit)
+    : state_(std::make_shared<State>(asio_service, retransmit)) {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  ScheduleRetransmission(state_);
+}
+
+SyncRetransmitter::~SyncRetransmitter() {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  state_->stopped = true;
+  boost::system::error_code error;
+  state_->timer.cancel(error);
+}
+
+void SyncRetransmitter::ScheduleRetransmission(std::shared_ptr<State> state) {
+  state->timer.expires_from_now(state->interval);
+  state->timer.async_wait([state](const boost::system::error_code& error) {
+    Retransmit(state, error);
+  });
+}
+
+void SyncRetransmitter::Retransmit(std::shared_ptr<State> state,
+                                   const boost::system::error_code& error) {
+  std::lock_guard<std::mutex> lock(state->mutex);
+  if (state->stopped || error == boost::asio::error::operation_aborted)
+    return;
+  try {
+    if (state->retransmit()) {
+      state->interval = std::min<std::chrono::steady_clock::duration>(
+          state->interval * 2, Parameters::max_sync_retransmission_interval);
+    } else {
+      state->interval = Parameters::sync_retransmission_interval;
+    }
+  }
+  catch (const std::exception& error) {
+    LOG(kError) << "SyncRetransmitter::Retransmit failed: "
+                << boost::diagnostic_information(error);
+  }
+  ScheduleRetransmission(state);
+}
+
+}  // namespace detail
+
 nfs::MessageId HashStringToMessageId(const std::string& input) {
   std::hash<std::string> hash_fn;
   return nfs::MessageId(static_cast<nfs::MessageId::value_type>(hash_fn(input)));
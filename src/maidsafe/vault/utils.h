@@ -19,20 +19,37 @@
 #ifndef MAIDSAFE_VAULT_UTILS_H_
 #define MAIDSAFE_VAULT_UTILS_H_
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "boost/asio/steady_timer.hpp"
 #include "leveldb/db.h"
+#include "leveldb/slice.h"
+#include "leveldb/write_batch.h"
 
+#include "maidsafe/common/asio_service.h"
 #include "maidsafe/common/node_id.h"
 #include "maidsafe/common/data_types/data_name_variant.h"
 #include "maidsafe/routing/routing_api.h"
 
+#include "maidsafe/vault/config.h"
 #include "maidsafe/vault/key.h"
 #include "maidsafe/nfs/message_types.h"
 #include "maidsafe/vault/sync.h"
 #include "maidsafe/vault/sync.pb.h"
 #include "maidsafe/vault/key_utils.h"
+#include "maidsafe/vault/parameters.h"
+#include "maidsafe/vault/storage_engine.h"
 
 
 namespace maidsafe {
@@ -135,6 +152,11 @@ struct PartialRequestor {
 };
 
 void InitialiseDirectory(const boost::filesystem::path& directory);
+
+// Returns the directory under 'vault_root_dir' holding the named persona's db, or an empty path
+// (i.e. a non-persistent db) if 'vault_root_dir' is empty.
+boost::filesystem::path PersonaDbPath(const boost::filesystem::path& vault_root_dir,
+                                      const std::string& persona_dir_name);
 // bool ShouldRetry(routing::Routing& routing, const nfs::Message& message);
 
 template <typename Data>
@@ -184,53 +206,234 @@ struct GroupOrKeyType<PersonaType, typename ToVoid<typename PersonaType::GroupNa
   }
 };
 
+// Accumulates puts and deletes into leveldb::WriteBatch commits of at most
+// Parameters::max_db_write_batch_count operations each.  Each commit is atomic.  Outstanding
+// operations are only applied by calling Flush(); they are discarded on destruction.  Throws on
+// storage errors.
+class DbBatchWriter {
+ public:
+  explicit DbBatchWriter(StorageEngine& db);
+  void Put(const leveldb::Slice& key, const leveldb::Slice& value);
+  void Delete(const leveldb::Slice& key);
+  void Flush();
+
+ private:
+  DbBatchWriter(const DbBatchWriter&);
+  DbBatchWriter& operator=(const DbBatchWriter&);
+  void FlushIfFull();
+
+  StorageEngine& db_;
+  leveldb::WriteBatch batch_;
+  size_t count_;
+};
+
+// A db key of fixed width, encoded in place so that building one needs no heap allocation.  It
+// converts implicitly to a leveldb::Slice viewing its bytes, so must outlive any such slice.
+template <size_t kSize>
+class FixedWidthKey {
+ public:
+  FixedWidthKey() : bytes_() {}
+  // Copies the first kSize bytes of 'key', e.g. to keep an iterator's key once it has moved on.
+  explicit FixedWidthKey(const leveldb::Slice& key) : bytes_() {
+    assert(key.size() >= kSize);
+    std::memcpy(bytes_.data(), key.data(), kSize);
+  }
+  char* data() { return bytes_.data(); }
+  const char* data() const { return bytes_.data(); }
+  static size_t size() { return kSize; }
+  operator leveldb::Slice() const { return leveldb::Slice(bytes_.data(), kSize); }
+
+ private:
+  std::array<char, kSize> bytes_;
+};
+
+// In-memory bloom filter over db keys.  MayContain returning false means the key has definitely
+// never been added.  Keys can't be removed, so false positives accumulate as keys are deleted
+// from the db.  Thread-safe and lock-free: bits are set with an atomic OR on 64-bit words.
+// With kHashCount_ hashes the filter is useful up to about bit_count / 8 keys (a 2% false positive
+// rate once half the bits are set); beyond that nearly every lookup answers "maybe".  A warning is
+// logged when half the bits are set, and Parameters::db_existence_filter_bits should be raised.
+class ExistenceFilter {
+ public:
+  explicit ExistenceFilter(size_t bit_count);
+  void Add(const leveldb::Slice& key);
+  bool MayContain(const leveldb::Slice& key) const;
+
+ private:
+  ExistenceFilter(const ExistenceFilter&);
+  ExistenceFilter& operator=(const ExistenceFilter&);
+
+  static const int kHashCount_ = 6;
+  const size_t kBitCount_;
+  std::unique_ptr<std::atomic<uint64_t>[]> words_;
+  std::atomic<size_t> set_bit_count_;
+  std::atomic<bool> saturation_logged_;
+};
+
+// Returns the key under which merge operand 'sequence' of the value at 'db_key' is stored.
+std::string MakeMergeOperandKey(const leveldb::Slice& db_key, uint64_t sequence);
+
+// Returns the sequence for the next merge operand of the value at 'db_key': one past that of its
+// last pending operand, or 0 if it has none.  Sequences are per value and read back from the
+// store, so they keep increasing across restarts and clock changes.
+uint64_t NextMergeSequence(leveldb::Iterator& db_iter, const leveldb::Slice& db_key);
+
+// Reads the value stored at 'db_key' and folds in any merge operands stored after it.  'db_iter'
+// must be positioned at the first entry not less than 'db_key', and is left at the first entry
+// after the value's operands.  The keys of the operands read are appended to 'operand_keys' if
+// non-null.  Returns false if there's no value once the operands are folded in.  A value with no
+// operands is returned as stored, without being parsed.
+template <typename Value>
+bool ReadMergedValue(leveldb::Iterator& db_iter, const leveldb::Slice& db_key,
+                     std::string& serialised_value, std::vector<std::string>* operand_keys) {
+  bool found(false), merged(false);
+  std::unique_ptr<Value> value;
+  if (db_iter.Valid() && db_iter.key() == db_key) {
+    serialised_value = db_iter.value().ToString();
+    found = true;
+    db_iter.Next();
+  }
+  for (; db_iter.Valid() && db_iter.key().starts_with(db_key) &&
+         db_iter.key().size() == db_key.size() + MergeSequenceWidth::value;
+       db_iter.Next()) {
+    if (found && !merged)
+      value.reset(new Value(serialised_value));
+    merged = true;
+    if (MergeOperator<Value>::Apply(db_iter.value().ToString(), value) == DbAction::kDelete)
+      value.reset();
+    if (operand_keys)
+      operand_keys->push_back(db_iter.key().ToString());
+  }
+  if (!db_iter.status().ok())
+    BOOST_THROW_EXCEPTION(MakeError(VaultErrors::failed_to_handle_request));
+  if (!merged)
+    return found;
+  if (!value)
+    return false;
+  serialised_value = value->Serialise();
+  return true;
+}
+
 }  // namespace detail
 
-std::unique_ptr<leveldb::DB> InitialiseLevelDb(const boost::filesystem::path& db_path);
+// If 'reuse_existing' is false, any existing db at 'db_path' is destroyed first.  Otherwise an
+// existing db is opened as-is, or a new one created if missing.  The db is opened with
+// 'db_options', which are logged.
+std::unique_ptr<leveldb::DB> InitialiseLevelDb(
+    const boost::filesystem::path& db_path, bool reuse_existing = false,
+    const detail::DbOptions& db_options = detail::DbOptions());
 
 
 // ============================ sync utils =========================================================
 namespace detail {
+// Name of the group to which syncs for 'key' are sent.  Keys of account personas carry the group
+// name; otherwise the sync goes to the group around the key's name.  'group_name()' returns by
+// value, so the name is copied out rather than referenced.
+template <typename KeyType>
+auto SyncGroupName(const KeyType& key, int) -> decltype(key.group_name(), std::string()) {
+  return key.group_name()->string();
+}
+
+template <typename KeyType>
+std::string SyncGroupName(const KeyType& key, ...) {
+  return key.name.string();
+}
+
+template <typename UnresolvedAction>
+void AddToSyncBatch(const UnresolvedAction& unresolved_action, protobuf::SyncBatch& proto_batch) {
+  protobuf::Sync& proto_sync(*proto_batch.add_syncs());
+  proto_sync.set_serialised_unresolved_action(unresolved_action.Serialise());
+  proto_sync.set_action_type(static_cast<int32_t>(unresolved_action.action.kActionId));
+}
+
+template <typename Dispatcher, typename UnresolvedAction>
+void SendSyncAction(Dispatcher& dispatcher, const UnresolvedAction& unresolved_action) {
+  protobuf::SyncBatch proto_batch;
+  AddToSyncBatch(unresolved_action, proto_batch);
+  dispatcher.SendSync(unresolved_action.key, proto_batch.SerializeAsString());
+}
+
+// Sends the actions in as few messages as possible: one per destination group, each carrying up to
+// Parameters::max_sync_batch_count actions.
 template <typename Dispatcher, typename UnresolvedAction>
 void SendSync(Dispatcher& dispatcher,
               const std::vector<UnresolvedAction>& unresolved_actions) {
-  protobuf::Sync proto_sync;
-  for (const auto& unresolved_action : unresolved_actions) {
-    proto_sync.Clear();
-    proto_sync.set_serialised_unresolved_action(unresolved_action->Serialise());
-    proto_sync.set_action_type(static_cast<int32_t>(unresolved_action->action.kActionId));
-//    LOG(kInfo) << "MaidManager send sync action " << proto_sync.action_type();
-    dispatcher.SendSync(unresolved_action->key, proto_sync.SerializeAsString());
+  // Per destination group, the index of an action addressed to it, and the batch being filled.
+  std::unordered_map<std::string, std::pair<size_t, protobuf::SyncBatch>> batches;
+  for (size_t i(0); i != unresolved_actions.size(); ++i) {
+    auto& batch(batches[SyncGroupName(unresolved_actions[i]->key, 0)]);
+    if (batch.second.syncs_size() == 0)
+      batch.first = i;
+    AddToSyncBatch(*unresolved_actions[i], batch.second);
+    if (static_cast<size_t>(batch.second.syncs_size()) >= Parameters::max_sync_batch_count) {
+      dispatcher.SendSync(unresolved_actions[batch.first]->key, batch.second.SerializeAsString());
+      batch.second.Clear();
+    }
+  }
+  for (const auto& batch : batches) {
+    if (batch.second.second.syncs_size() != 0) {
+      dispatcher.SendSync(unresolved_actions[batch.second.first]->key,
+                          batch.second.second.SerializeAsString());
+    }
   }
 }
 
-template <typename Dispatcher, typename UnresolvedAction, typename NewUnresolvedAction>
-void IncrementAttemptsAndSendSync(Dispatcher& dispatcher,
-                                  Sync<UnresolvedAction>& sync_type,
-                                  const NewUnresolvedAction& unresolved_action,
-                                  typename std::enable_if<std::is_same<UnresolvedAction,
-                                  NewUnresolvedAction>::value >::type* = 0) {
+// If this node has added actions still unresolved, counts a sync attempt against every action,
+// pruning expired and fully-resolved ones, then resends the rest of this node's.  Returns false if
+// there was nothing to resend.  Ticks with nothing to resend aren't counted, so actions expire
+// after Sync's kSyncCounterMax_ resend rounds rather than after that many timer ticks.
+template <typename Dispatcher, typename UnresolvedAction>
+bool RetransmitSync(Dispatcher& dispatcher, Sync<UnresolvedAction>& sync_type) {
+  if (!sync_type.HasUnresolvedActions())
+    return false;
   sync_type.IncrementSyncAttempts();
   auto unresolved_actions(sync_type.GetUnresolvedActions());
-  std::unique_ptr<UnresolvedAction> unresolved_action_ptr(new UnresolvedAction(unresolved_action));
-  unresolved_actions.push_back(std::move(unresolved_action_ptr));
-//  LOG(kVerbose) << "IncrementAttemptsAndSendSync, for MaidManagerSerive, has "
-//                << unresolved_actions.size() << " unresolved_actions";
+  if (unresolved_actions.empty())
+    return false;
+  LOG(kVerbose) << "RetransmitSync " << Sync<UnresolvedAction>::kActionId << " resending "
+                << unresolved_actions.size() << " unresolved_actions";
   SendSync(dispatcher, unresolved_actions);
+  return true;
 }
 
+// Runs a Sync's retransmission from a timer on 'asio_service'.  The first run is after
+// Parameters::sync_retransmission_interval.  While 'retransmit' returns true the interval doubles,
+// up to Parameters::max_sync_retransmission_interval, and it's reset once 'retransmit' returns
+// false.  'retransmit' isn't run once the destructor has returned.
+class SyncRetransmitter {
+ public:
+  SyncRetransmitter(AsioService& asio_service, std::function<bool()> retransmit);
+  ~SyncRetransmitter();
+
+ private:
+  SyncRetransmitter(const SyncRetransmitter&);
+  SyncRetransmitter& operator=(const SyncRetransmitter&);
+
+  // Shared with the pending timer handler, which may outlive the retransmitter.
+  struct State {
+    State(AsioService& asio_service, std::function<bool()> retransmit_in);
+    std::mutex mutex;
+    bool stopped;
+    boost::asio::steady_timer timer;
+    std::chrono::steady_clock::duration interval;
+    std::function<bool()> retransmit;
+  };
+
+  // Must be called with 'state->mutex' held.
+  static void ScheduleRetransmission(std::shared_ptr<State> state);
+  static void Retransmit(std::shared_ptr<State> state, const boost::system::error_code& error);
+
+  std::shared_ptr<State> state_;
+};
 
-template <typename Dispatcher, typename UnresolvedAction, typename NewUnresolvedAction>
-void IncrementAttemptsAndSendSync(Dispatcher& dispatcher,
-                                  Sync<UnresolvedAction>& sync_type,
-                                  const NewUnresolvedAction& /*unresolved_action*/,
-                                  typename std::enable_if<!std::is_same<UnresolvedAction,
-                                  NewUnresolvedAction>::value >::type* = 0) {
-  sync_type.IncrementSyncAttempts();
-  auto unresolved_actions(sync_type.GetUnresolvedActions());
-//  LOG(kVerbose) << "IncrementAttemptsAndSendSync, for MaidManagerSerive, has "
-//                << unresolved_actions.size() << " unresolved_actions";
-  SendSync(dispatcher, unresolved_actions);
+// The retransmitter uses 'dispatcher' and 'sync_type' until it's destroyed, so a service must
+// destroy it before them, e.g. by declaring it after them.
+template <typename Dispatcher, typename UnresolvedAction>
+std::unique_ptr<SyncRetransmitter> MakeSyncRetransmitter(AsioService& asio_service,
+                                                         Dispatcher& dispatcher,
+                                                         Sync<UnresolvedAction>& sync_type) {
+  return std::unique_ptr<SyncRetransmitter>(new SyncRetransmitter(
+      asio_service, [&dispatcher, &sync_type] { return RetransmitSync(dispatcher, sync_type); }));
 }
 
 }  // namespace detail
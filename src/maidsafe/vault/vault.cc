@@ -41,13 +41,14 @@ Vault::Vault(const passport::Pmid& pmid, const boost::filesystem::path& vault_ro
       public_pmid_helper_(),
       maid_manager_service_(
           std::move(std::unique_ptr<MaidManagerService>(new MaidManagerService(pmid, *routing_,
-                                                                               data_getter_)))),
-      version_handler_service_(std::move(
-          std::unique_ptr<VersionHandlerService>(new VersionHandlerService(pmid, *routing_)))),
+                                                                               data_getter_,
+                                                                               vault_root_dir)))),
+      version_handler_service_(std::move(std::unique_ptr<VersionHandlerService>(
+          new VersionHandlerService(pmid, *routing_, vault_root_dir)))),
       data_manager_service_(std::move(std::unique_ptr<DataManagerService>(
-          new DataManagerService(pmid, *routing_, data_getter_)))),
-      pmid_manager_service_(
-          std::move(std::unique_ptr<PmidManagerService>(new PmidManagerService(pmid, *routing_)))),
+          new DataManagerService(pmid, *routing_, data_getter_, vault_root_dir)))),
+      pmid_manager_service_(std::move(std::unique_ptr<PmidManagerService>(
+          new PmidManagerService(pmid, *routing_, vault_root_dir)))),
       pmid_node_service_(std::move(std::unique_ptr<PmidNodeService>(
           new PmidNodeService(pmid, *routing_, data_getter_, vault_root_dir)))),
       // FIXME need to specialise
@@ -41,6 +41,7 @@
 
 // #include "maidsafe/client_manager/vault_controller.h"
 
+#include "maidsafe/vault/parameters.h"
 #include "maidsafe/vault/types.h"
 #include "maidsafe/vault/vault.h"
 
@@ -106,7 +107,51 @@ void GetIdentityAndEndpoints(po::variables_map& variables_map,
 }
 #endif
 
+// Options for each persona's store are named e.g. "data_manager_db.block_cache_size", so can be
+// grouped under a "[data_manager_db]" section of a config file.
+void AddDbOptions(po::options_description& config_file_options, const std::string& persona) {
+  const std::string prefix(persona + "_db.");
+  config_file_options.add_options()
+      ((prefix + "in_memory").c_str(), po::value<bool>(),
+          "Hold the store in memory only, rather than in LevelDB")
+      ((prefix + "block_cache_size").c_str(), po::value<size_t>(),
+          "LevelDB block cache size in bytes")
+      ((prefix + "write_buffer_size").c_str(), po::value<size_t>(),
+          "LevelDB write buffer size in bytes")
+      ((prefix + "bloom_filter_bits_per_key").c_str(), po::value<int>(),
+          "LevelDB bloom filter bits per key (0 disables)")
+      ((prefix + "compression").c_str(), po::value<bool>(), "Enable LevelDB compression")
+      ((prefix + "verify_checksums").c_str(), po::value<bool>(),
+          "Verify LevelDB checksums on every read");
+}
+
+void ApplyDbOptions(const po::variables_map& variables_map, const std::string& persona,
+                    detail::DbOptions& db_options) {
+  const std::string prefix(persona + "_db.");
+  if (variables_map.count(prefix + "in_memory") != 0) {
+    db_options.storage_engine = variables_map.at(prefix + "in_memory").as<bool>() ?
+        detail::StorageEngineType::kInMemory : detail::StorageEngineType::kLevelDb;
+  }
+  if (variables_map.count(prefix + "block_cache_size") != 0)
+    db_options.block_cache_size = variables_map.at(prefix + "block_cache_size").as<size_t>();
+  if (variables_map.count(prefix + "write_buffer_size") != 0)
+    db_options.write_buffer_size = variables_map.at(prefix + "write_buffer_size").as<size_t>();
+  if (variables_map.count(prefix + "bloom_filter_bits_per_key") != 0) {
+    db_options.bloom_filter_bits_per_key =
+        variables_map.at(prefix + "bloom_filter_bits_per_key").as<int>();
+  }
+  if (variables_map.count(prefix + "compression") != 0)
+    db_options.compression = variables_map.at(prefix + "compression").as<bool>();
+  if (variables_map.count(prefix + "verify_checksums") != 0)
+    db_options.verify_checksums = variables_map.at(prefix + "verify_checksums").as<bool>();
+}
+
 void RunVault(po::variables_map& variables_map) {
+  ApplyDbOptions(variables_map, "data_manager", detail::Parameters::data_manager_db_options);
+  ApplyDbOptions(variables_map, "version_handler",
+                 detail::Parameters::version_handler_db_options);
+  ApplyDbOptions(variables_map, "maid_manager", detail::Parameters::maid_manager_db_options);
+  ApplyDbOptions(variables_map, "pmid_manager", detail::Parameters::pmid_manager_db_options);
   auto chunk_path(maidsafe::GetPathFromProgramOptions("chunk_path", variables_map, true, true));
   std::vector<boost::asio::ip::udp::endpoint> peer_endpoints;
   std::unique_ptr<passport::Pmid> pmid;
@@ -201,6 +246,10 @@ po::options_description PopulateVariablesMap(int argc, char* argv[],
                         fs::path(fs::temp_directory_path(error_code) / "vault_chunks").string()),
           "Directory to store chunks in")(
        "vmid", po::value<std::string>(), "ID to identify to vault manager");
+  AddDbOptions(config_file_options, "data_manager");
+  AddDbOptions(config_file_options, "version_handler");
+  AddDbOptions(config_file_options, "maid_manager");
+  AddDbOptions(config_file_options, "pmid_manager");
 #ifdef TESTING
   AddTestingOptions(config_file_options);
 #endif
@@ -57,16 +57,27 @@ inline bool FromVersionHandler(const Message& message) {
 
 
 VersionHandlerService::VersionHandlerService(const passport::Pmid& pmid,
-                                             routing::Routing& routing)
+                                             routing::Routing& routing,
+                                             const boost::filesystem::path& vault_root_dir)
     : routing_(routing),
       dispatcher_(routing),
       accumulator_mutex_(),
-      accumulator_(),
-      db_(),
+      accumulator_(detail::Parameters::version_handler_accumulator_options),
+      db_(detail::PersonaDbPath(vault_root_dir, "version_handler"),
+          detail::Parameters::version_handler_db_options),
       kThisNodeId_(routing_.kNodeId()),
       sync_create_version_tree_(NodeId(pmid.name()->string())),
       sync_put_versions_(NodeId(pmid.name()->string())),
-      sync_delete_branch_until_fork_(NodeId(pmid.name()->string())) {}
+      sync_delete_branch_until_fork_(NodeId(pmid.name()->string())),
+      asio_service_(1),
+      sync_retransmitters_() {
+  sync_retransmitters_.push_back(
+      detail::MakeSyncRetransmitter(asio_service_, dispatcher_, sync_create_version_tree_));
+  sync_retransmitters_.push_back(
+      detail::MakeSyncRetransmitter(asio_service_, dispatcher_, sync_put_versions_));
+  sync_retransmitters_.push_back(
+      detail::MakeSyncRetransmitter(asio_service_, dispatcher_, sync_delete_branch_until_fork_));
+}
 
 template<>
 void VersionHandlerService::HandleMessage(
@@ -178,27 +189,41 @@ void VersionHandlerService::HandleMessage(
     const typename SynchroniseFromVersionHandlerToVersionHandler::Sender& sender,
     const typename SynchroniseFromVersionHandlerToVersionHandler::Receiver& /*receiver*/) {
   LOG(kVerbose) << "VersionHandler::HandleMessage SynchroniseFromVersionHandlerToVersionHandler";
-  protobuf::Sync proto_sync;
-  if (!proto_sync.ParseFromString(message.contents->data))
+  protobuf::SyncBatch proto_sync_batch;
+  if (!proto_sync_batch.ParseFromString(message.contents->data))
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
 
+  for (const auto& proto_sync : proto_sync_batch.syncs()) {
+    try {
+      HandleSync(proto_sync, sender, message.id);
+    }
+    catch (const maidsafe_error& error) {
+      LOG(kError) << "SynchroniseFromVersionHandlerToVersionHandler failed to handle action type "
+                  << proto_sync.action_type() << ": " << boost::diagnostic_information(error);
+    }
+  }
+}
+
+void VersionHandlerService::HandleSync(const protobuf::Sync& proto_sync,
+                                       const routing::GroupSource& sender,
+                                       nfs::MessageId message_id) {
   switch (static_cast<nfs::MessageAction>(proto_sync.action_type())) {
     case ActionVersionHandlerCreateVersionTree::kActionId: {
       VersionHandler::UnresolvedCreateVersionTree unresolved_action(
                                                       proto_sync.serialised_unresolved_action(),
                                                       sender.sender_id, routing_.kNodeId());
-      LOG(kVerbose) << "VersionHandlerSync -- CreateVersionTree: " << message.id;
+      LOG(kVerbose) << "VersionHandlerSync -- CreateVersionTree: " << message_id;
       auto resolved_action(sync_create_version_tree_.AddUnresolvedAction(unresolved_action));
       if (resolved_action) {
         try {
-          LOG(kInfo) << "VersionHandlerSync -- CreateVersionTree -Commit: " << message.id;
+          LOG(kInfo) << "VersionHandlerSync -- CreateVersionTree -Commit: " << message_id;
           db_.Commit(resolved_action->key, resolved_action->action);
           dispatcher_.SendCreateVersionTreeResponse(
               resolved_action->action.originator, resolved_action->key,
               maidsafe_error(CommonErrors::success), resolved_action->action.message_id);
         }
         catch (const maidsafe_error& error) {
-          LOG(kError) << message.id << " Failed to create version: "
+          LOG(kError) << message_id << " Failed to create version: "
                       << boost::diagnostic_information(error);
           dispatcher_.SendCreateVersionTreeResponse(
               resolved_action->action.originator, resolved_action->key, error,
@@ -211,11 +236,11 @@ void VersionHandlerService::HandleMessage(
       VersionHandler::UnresolvedPutVersion unresolved_action(
                                                proto_sync.serialised_unresolved_action(),
                                                sender.sender_id, routing_.kNodeId());
-      LOG(kVerbose) << "VersionHandlerSync: " << message.id;
+      LOG(kVerbose) << "VersionHandlerSync: " << message_id;
       auto resolved_action(sync_put_versions_.AddUnresolvedAction(unresolved_action));
       if (resolved_action) {
         try {
-          LOG(kInfo) << "VersionHandlerSync-Commit: " << message.id;
+          LOG(kInfo) << "VersionHandlerSync-Commit: " << message_id;
           db_.Commit(resolved_action->key, resolved_action->action);
           StructuredDataVersions::VersionName tip_of_tree;
           if (resolved_action->action.tip_of_tree) {
@@ -226,7 +251,7 @@ void VersionHandlerService::HandleMessage(
           }
         }
         catch (const maidsafe_error& error) {
-          LOG(kError) << message.id << " Failed to put version: "
+          LOG(kError) << message_id << " Failed to put version: "
                       << boost::diagnostic_information(error);
           dispatcher_.SendPutVersionResponse(
               resolved_action->action.originator, resolved_action->key,
@@ -310,10 +335,7 @@ void VersionHandlerService::HandleCreateVersionTree(const VersionHandler::Key& k
 
 template <typename UnresolvedAction>
 void VersionHandlerService::DoSync(const UnresolvedAction& unresolved_action) {
-  detail::IncrementAttemptsAndSendSync(dispatcher_, sync_create_version_tree_, unresolved_action);
-  detail::IncrementAttemptsAndSendSync(dispatcher_, sync_put_versions_, unresolved_action);
-  detail::IncrementAttemptsAndSendSync(dispatcher_, sync_delete_branch_until_fork_,
-                                       unresolved_action);
+  detail::SendSyncAction(dispatcher_, unresolved_action);
 }
 
 // void VersionHandlerService::ValidateClientSender(const nfs::Message& message) const {
@@ -19,15 +19,18 @@
 #ifndef MAIDSAFE_VAULT_VERSION_HANDLER_SERVICE_H_
 #define MAIDSAFE_VAULT_VERSION_HANDLER_SERVICE_H_
 
+#include <memory>
 #include <mutex>
 #include <string>
 #include <type_traits>
 #include <vector>
 
+#include "boost/filesystem/path.hpp"
 #include "boost/mpl/vector.hpp"
 #include "boost/mpl/insert_range.hpp"
 #include "boost/mpl/end.hpp"
 
+#include "maidsafe/common/asio_service.h"
 #include "maidsafe/common/types.h"
 #include "maidsafe/passport/types.h"
 #include "maidsafe/routing/routing_api.h"
@@ -40,6 +43,7 @@
 #include "maidsafe/vault/sync.h"
 #include "maidsafe/vault/sync.pb.h"
 #include "maidsafe/vault/types.h"
+#include "maidsafe/vault/utils.h"
 #include "maidsafe/vault/message_types.h"
 #include "maidsafe/vault/version_handler/version_handler.h"
 #include "maidsafe/vault/version_handler/dispatcher.h"
@@ -70,7 +74,9 @@ class VersionHandlerService {
   typedef void HandleMessageReturnType;
   typedef Identity VersionHandlerAccountName;
 
-  VersionHandlerService(const passport::Pmid& pmid, routing::Routing& routing);
+  // If 'vault_root_dir' is empty, the version db is not persisted.
+  VersionHandlerService(const passport::Pmid& pmid, routing::Routing& routing,
+                        const boost::filesystem::path& vault_root_dir = boost::filesystem::path());
 
   template <typename MessageType>
   void HandleMessage(const MessageType& message, const typename MessageType::Sender& sender,
@@ -91,6 +97,10 @@ class VersionHandlerService {
   VersionHandlerService(VersionHandlerService&&);
   VersionHandlerService& operator=(VersionHandlerService&&);
 
+  // Applies one action from a received batch of syncs.  'message_id' is that of the batch message.
+  void HandleSync(const protobuf::Sync& proto_sync, const routing::GroupSource& sender,
+                  nfs::MessageId message_id);
+
   template <typename UnresolvedAction>
   void DoSync(const UnresolvedAction& unresolved_action);
 
@@ -144,6 +154,8 @@ class VersionHandlerService {
   Sync<VersionHandler::UnresolvedCreateVersionTree> sync_create_version_tree_;
   Sync<VersionHandler::UnresolvedPutVersion> sync_put_versions_;
   Sync<VersionHandler::UnresolvedDeleteBranchUntilFork> sync_delete_branch_until_fork_;
+  AsioService asio_service_;
+  std::vector<std::unique_ptr<detail::SyncRetransmitter>> sync_retransmitters_;
 };
 
 template <typename MessageType>